@@ -0,0 +1,48 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../lib/scheduler.h"
+
+namespace {
+
+void Run(const char* name, size_t tasks, bool chained) {
+  TTaskScheduler scheduler;
+  int counter = 0;
+
+  auto previous = scheduler.add([&counter] { return ++counter; });
+  for (size_t i = 1; i < tasks; ++i) {
+    if (chained && i % 1000 != 0) {
+      previous = scheduler.add([](int x) { return x + 1; },
+                               scheduler.getFutureResult<int>(previous));
+    } else {
+      previous = scheduler.add([&counter] { return ++counter; });
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  scheduler.executeAll();
+  double elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count();
+
+  scheduler.reset();
+  start = std::chrono::steady_clock::now();
+  scheduler.executeAll();
+  double rerun = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count();
+
+  std::cout << name << ": first run " << elapsed / static_cast<double>(tasks) << " ns/task"
+            << ", re-run after reset() " << rerun / static_cast<double>(tasks) << " ns/task"
+            << " (" << tasks << " tasks)" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  size_t tasks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  Run("independent", tasks, false);
+  Run("chains     ", tasks, true);
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../lib/scheduler.h"
+
+namespace {
+
+// Grows a random DAG in batches and runs executeAll() after each batch.
+// With `full_resort` an unrelated edge insertion invalidates the cached
+// order every round, which forces the old whole-graph TopSort.
+void Run(const char* name, size_t nodes, size_t batch, bool full_resort) {
+  TTaskScheduler scheduler;
+  std::mt19937 random(42);
+  std::vector<std::shared_ptr<Task<int>>> tasks;
+  tasks.reserve(nodes);
+
+  auto outside = std::make_shared<Task<int>>([] { return 0; });
+  auto other = std::make_shared<Task<int>>([] { return 0; });
+
+  double slowest = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (tasks.size() < nodes) {
+    auto round_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < batch && tasks.size() < nodes; ++i) {
+      if (tasks.empty()) {
+        tasks.push_back(scheduler.add([] { return 1; }));
+        continue;
+      }
+      auto& parent = tasks[random() % tasks.size()];
+      tasks.push_back(scheduler.add([](int x) { return x + 1; },
+                                    scheduler.getFutureResult<int>(parent)));
+    }
+    if (full_resort) {
+      outside->AddDependendTask(other);
+    }
+    scheduler.executeAll();
+
+    double round = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - round_start).count();
+    slowest = std::max(slowest, round);
+  }
+  double total = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+
+  std::cout << name << ": " << nodes << " nodes in batches of " << batch
+            << ", total " << total << " ms, slowest add+execute round " << slowest
+            << " ms" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  size_t nodes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t batch = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+  size_t baseline_nodes = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200000;
+
+  Run("incremental order", nodes, batch, false);
+  Run("full re-sort     ", std::min(nodes, baseline_nodes), batch, true);
+
+  return 0;
+}
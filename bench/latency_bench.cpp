@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../lib/scheduler.h"
+
+namespace {
+
+// A request-sized graph: a root fanning out to `width` chains of `depth`
+// small steps, joined pairwise back down to one result.
+std::shared_ptr<Task<int>> Build(TTaskScheduler& scheduler, size_t width, size_t depth) {
+  auto root = scheduler.add([] { return 1; });
+  std::vector<std::shared_ptr<Task<int>>> level;
+  for (size_t i = 0; i < width; ++i) {
+    auto step = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(root));
+    for (size_t d = 1; d < depth; ++d) {
+      step = scheduler.add([](int x) { return x * 3 % 1000; }, scheduler.getFutureResult<int>(step));
+    }
+    level.push_back(step);
+  }
+  while (level.size() > 1) {
+    std::vector<std::shared_ptr<Task<int>>> next;
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      next.push_back(scheduler.add([](int a, int b) { return a + b; },
+                                   scheduler.getFutureResult<int>(level[i]),
+                                   scheduler.getFutureResult<int>(level[i + 1])));
+    }
+    if (level.size() % 2 != 0) {
+      next.push_back(level.back());
+    }
+    level = std::move(next);
+  }
+  return level.front();
+}
+
+void Run(const char* name, SchedulerOptions options, size_t iterations) {
+  constexpr size_t kWidth = 8;
+  constexpr size_t kDepth = 5;
+
+  TTaskScheduler scheduler(std::move(options));
+  auto result = Build(scheduler, kWidth, kDepth);
+  scheduler.executeAll();
+
+  LatencyHistogram latencies;
+  for (size_t i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    scheduler.reset();
+    scheduler.executeAll();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    latencies.Record(static_cast<uint64_t>(elapsed));
+    // Leave the workers idle between requests, as a server would.
+    auto idle_until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+    while (std::chrono::steady_clock::now() < idle_until) {
+    }
+  }
+
+  std::cout << name << ": p50 " << latencies.ValueAtPercentile(50) << " ns"
+            << ", p99 " << latencies.ValueAtPercentile(99) << " ns"
+            << ", max " << latencies.Max() << " ns"
+            << " (" << 1 + kWidth * kDepth + kWidth - 1 << " tasks, " << iterations
+            << " runs, result " << scheduler.getResult<int>(result) << ")" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  size_t workers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+
+  Run("serial     ", SchedulerOptions{}, iterations);
+  Run("eager      ", SchedulerOptions{.eager = true, .workers = workers}, iterations);
+  Run("low-latency", SchedulerOptions{.eager = true, .workers = workers,
+                                      .latency = LatencyOptions::Low()}, iterations);
+
+  return 0;
+}
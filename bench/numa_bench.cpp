@@ -0,0 +1,107 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../lib/scheduler.h"
+
+namespace {
+
+struct Block {
+  std::vector<double> data;
+  int node = -1;
+};
+
+// Inputs read on a different node than the one their producer ran on, and
+// their size. This compares where the two tasks ran; it is not a measure of
+// the memory traffic that actually crossed nodes.
+std::atomic<size_t> off_node_reads{0};
+std::atomic<size_t> off_node_bytes{0};
+
+void NoteRead(const Block& block) {
+  int node = ThreadPool::CurrentNode();
+  if (node != block.node) {
+    off_node_reads.fetch_add(1, std::memory_order_relaxed);
+    off_node_bytes.fetch_add(block.data.size() * sizeof(double), std::memory_order_relaxed);
+  }
+}
+
+Block Produce(size_t size, double seed) {
+  Block block;
+  block.node = ThreadPool::CurrentNode();
+  block.data.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    block.data[i] = seed + static_cast<double>(i);
+  }
+  return block;
+}
+
+Block Transform(const Block& input, double factor) {
+  NoteRead(input);
+  Block block;
+  block.node = ThreadPool::CurrentNode();
+  block.data.resize(input.data.size());
+  for (size_t i = 0; i < input.data.size(); ++i) {
+    block.data[i] = input.data[i] * factor;
+  }
+  return block;
+}
+
+double Join(const Block& left, const Block& right) {
+  NoteRead(left);
+  NoteRead(right);
+  double sum = 0;
+  for (size_t i = 0; i < left.data.size(); ++i) {
+    sum += left.data[i] - right.data[i];
+  }
+  return sum;
+}
+
+void Run(const char* name, bool locality, size_t diamonds, size_t block_size, size_t workers) {
+  off_node_reads = 0;
+  off_node_bytes = 0;
+
+  auto pool = std::make_shared<ThreadPool>(ThreadPoolOptions{
+      .workers = workers, .pin_workers = true, .locality = locality});
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    TTaskScheduler scheduler(SchedulerOptions{.pool = pool});
+    for (size_t i = 0; i < diamonds; ++i) {
+      int node = locality ? static_cast<int>(i % pool->NodeCount()) : -1;
+      auto root = scheduler.with(TaskOptions{.node = node})
+                      .add([block_size, i] { return Produce(block_size, static_cast<double>(i)); });
+      auto left = scheduler.add([](const Block& b) { return Transform(b, 2.0); },
+                                scheduler.getFutureResult<Block>(root));
+      auto right = scheduler.add([](const Block& b) { return Transform(b, 3.0); },
+                                 scheduler.getFutureResult<Block>(root));
+      scheduler.add([](const Block& l, const Block& r) { return Join(l, r); },
+                    scheduler.getFutureResult<Block>(left),
+                    scheduler.getFutureResult<Block>(right));
+    }
+    scheduler.executeAll();
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+
+  std::cout << name << ": " << elapsed << " ms"
+            << ", nodes = " << pool->NodeCount()
+            << ", inputs read off the producer's node = " << off_node_reads.load()
+            << " (" << off_node_bytes.load() / (1024 * 1024) << " MiB)"
+            << ", local steals = " << pool->LocalSteals()
+            << ", remote steals = " << pool->RemoteSteals() << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  size_t diamonds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+  size_t block_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : (1 << 20);
+  size_t workers = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+
+  Run("round-robin", false, diamonds, block_size, workers);
+  Run("node-local ", true, diamonds, block_size, workers);
+
+  return 0;
+}
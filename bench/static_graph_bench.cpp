@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "../lib/scheduler.h"
+#include "../lib/static_graph.h"
+
+namespace {
+
+using A = StaticInput<0, float>;
+using B = StaticInput<1, float>;
+using C = StaticInput<2, float>;
+
+using Id1 = StaticNode<[](float a, float c) { return -4 * a * c; }, A, C>;
+using Id2 = StaticNode<[](float b, float v) { return b * b + v; }, B, Id1>;
+using Id3 = StaticNode<[](float b, float d) { return -b + std::sqrt(d); }, B, Id2>;
+using Id4 = StaticNode<[](float b, float d) { return -b - std::sqrt(d); }, B, Id2>;
+using Id5 = StaticNode<[](float a, float v) { return v / (2 * a); }, A, Id3>;
+using Id6 = StaticNode<[](float a, float v) { return v / (2 * a); }, A, Id4>;
+
+float SolveDynamic(float a, float b, float c) {
+  TTaskScheduler scheduler;
+
+  auto id1 = scheduler.add([](float a, float c) { return -4 * a * c; }, a, c);
+  auto id2 = scheduler.add([](float b, float v) { return b * b + v; }, b,
+                           scheduler.getFutureResult<float>(id1));
+  auto id3 = scheduler.add([](float b, float d) { return -b + std::sqrt(d); }, b,
+                           scheduler.getFutureResult<float>(id2));
+  auto id4 = scheduler.add([](float b, float d) { return -b - std::sqrt(d); }, b,
+                           scheduler.getFutureResult<float>(id2));
+  auto id5 = scheduler.add([](float a, float v) { return v / (2 * a); }, a,
+                           scheduler.getFutureResult<float>(id3));
+  auto id6 = scheduler.add([](float a, float v) { return v / (2 * a); }, a,
+                           scheduler.getFutureResult<float>(id4));
+
+  scheduler.executeAll();
+  return scheduler.getResult<float>(id5) + scheduler.getResult<float>(id6);
+}
+
+float SolveStatic(TStaticGraph<Id5, Id6>& graph, float a, float b, float c) {
+  graph.executeAll(a, b, c);
+  return graph.getResult<Id5>() + graph.getResult<Id6>();
+}
+
+template <typename Solve>
+double Measure(const char* name, size_t iterations, Solve solve) {
+  volatile float sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    sink = sink + solve(1.0f, -static_cast<float>(i % 100) - 3.0f, 2.0f);
+  }
+  double elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count() / static_cast<double>(iterations);
+
+  std::cout << name << ": " << elapsed << " ns/solve" << std::endl;
+  return elapsed;
+}
+
+}
+
+int main(int argc, char** argv) {
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  double dynamic = Measure("dynamic scheduler", iterations, SolveDynamic);
+
+  TStaticGraph<Id5, Id6> graph;
+  double fixed = Measure("static graph     ", iterations, [&graph](float a, float b, float c) {
+    return SolveStatic(graph, a, b, c);
+  });
+
+  std::cout << "speedup: " << dynamic / fixed << "x" << std::endl;
+  return 0;
+}
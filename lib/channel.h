@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "task.h"
+#include "thread_pool.h"
+
+template <typename T>
+class Channel {
+public:
+  explicit Channel(size_t capacity) : closed_(false) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  bool TryPush(T& value) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    pushed_.Notify();
+    return true;
+  }
+
+  bool TryPop(T& value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    value = std::move(cell->data);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    popped_.Notify();
+    return true;
+  }
+
+  // A full channel parks the caller after a short spin. On a pool thread a
+  // spare serves the queues meanwhile, so the consumer gets to run even when
+  // every worker is a blocked producer.
+  void Push(T value) {
+    for (size_t spins = 0; spins < kSpins; ++spins) {
+      if (TryPush(value)) {
+        return;
+      }
+    }
+    ThreadPool::Blocking blocking;
+    while (true) {
+      uint32_t seen = popped_.Prepare();
+      if (TryPush(value)) {
+        popped_.Cancel();
+        return;
+      }
+      popped_.Wait(seen);
+    }
+  }
+
+  bool Pop(T& value) {
+    for (size_t spins = 0; spins < kSpins; ++spins) {
+      if (TryPop(value)) {
+        return true;
+      }
+    }
+    if (closed_.load(std::memory_order_acquire)) {
+      return Drain(value);
+    }
+    ThreadPool::Blocking blocking;
+    while (true) {
+      uint32_t seen = pushed_.Prepare();
+      if (TryPop(value)) {
+        pushed_.Cancel();
+        return true;
+      }
+      if (closed_.load(std::memory_order_acquire)) {
+        pushed_.Cancel();
+        return Drain(value);
+      }
+      pushed_.Wait(seen);
+    }
+  }
+
+  void Close(std::exception_ptr error = nullptr) {
+    error_ = error;
+    closed_.store(true, std::memory_order_release);
+    pushed_.Notify();
+  }
+
+  bool IsClosed() const { return closed_.load(std::memory_order_acquire); }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static constexpr size_t kSpins = 64;
+
+  // Wakes threads parked until the other end makes progress. The counter only
+  // moves while someone waits, so the uncontended path is a fence and a load.
+  struct Signal {
+    alignas(64) std::atomic<uint32_t> waiters{0};
+    std::atomic<uint32_t> count{0};
+
+    // Registers a waiter; retry the operation before calling Wait.
+    uint32_t Prepare() {
+      waiters.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      return count.load(std::memory_order_acquire);
+    }
+
+    void Cancel() { waiters.fetch_sub(1, std::memory_order_relaxed); }
+
+    void Wait(uint32_t seen) {
+      count.wait(seen, std::memory_order_acquire);
+      waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Notify() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiters.load(std::memory_order_relaxed) != 0) {
+        count.fetch_add(1, std::memory_order_release);
+        count.notify_all();
+      }
+    }
+  };
+
+  bool Drain(T& value) {
+    if (TryPop(value)) {
+      return true;
+    }
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+  alignas(64) std::atomic<bool> closed_;
+  std::exception_ptr error_;
+  Signal pushed_;
+  Signal popped_;
+};
+
+template <typename T>
+class StreamResult {
+public:
+  using value_type = T;
+
+  StreamResult(std::shared_ptr<Channel<T>> channel, std::shared_ptr<Task<void>> task)
+      : channel_(std::move(channel)), task_(std::move(task)) {}
+
+  Channel<T>& channel() const { return *channel_; }
+
+  std::shared_ptr<Task<void>> getTask() const { return task_; }
+
+private:
+  std::shared_ptr<Channel<T>> channel_;
+  std::shared_ptr<Task<void>> task_;
+};
@@ -0,0 +1,111 @@
+#include "executor.h"
+
+namespace {
+
+thread_local std::deque<Function<void>>* inline_queue = nullptr;
+
+}
+
+void InlineExecutor::Submit(Function<void> job, JobOptions) {
+  if (inline_queue != nullptr) {
+    inline_queue->push_back(std::move(job));
+    return;
+  }
+
+  std::deque<Function<void>> queue;
+  queue.push_back(std::move(job));
+  inline_queue = &queue;
+  struct Restore {
+    ~Restore() { inline_queue = nullptr; }
+  } restore;
+
+  while (!queue.empty()) {
+    Function<void> next = std::move(queue.front());
+    queue.pop_front();
+    next();
+  }
+}
+
+std::shared_ptr<InlineExecutor> InlineExecutor::Instance() {
+  static std::shared_ptr<InlineExecutor> instance = std::make_shared<InlineExecutor>();
+  return instance;
+}
+
+BlockingExecutor::~BlockingExecutor() {
+  std::unordered_map<std::thread::id, std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+
+  // Threads only leave through exited_, so joining drains every one.
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!threads_.empty()) {
+    threads = std::move(threads_);
+    threads_.clear();
+    exited_.clear();
+    lock.unlock();
+    for (auto& [id, thread] : threads) {
+      thread.join();
+    }
+    threads.clear();
+    lock.lock();
+  }
+}
+
+void BlockingExecutor::Submit(Function<void> job, JobOptions) {
+  std::vector<std::thread> finished;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+    for (auto id : exited_) {
+      auto it = threads_.find(id);
+      finished.push_back(std::move(it->second));
+      threads_.erase(it);
+    }
+    exited_.clear();
+
+    if (jobs_.size() > idle_ && threads_.size() < options_.max_threads) {
+      std::thread thread([this] { Loop(); });
+      threads_.emplace(thread.get_id(), std::move(thread));
+    }
+  }
+  cv_.notify_one();
+
+  for (auto& thread : finished) {
+    thread.join();
+  }
+}
+
+size_t BlockingExecutor::Threads() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_.size() - exited_.size();
+}
+
+void BlockingExecutor::Loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (!jobs_.empty()) {
+      Function<void> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+      continue;
+    }
+    if (stopping_) {
+      break;
+    }
+
+    ++idle_;
+    bool woken = cv_.wait_for(lock, options_.keep_alive, [this] {
+      return stopping_ || !jobs_.empty();
+    });
+    --idle_;
+    if (!woken) {
+      break;
+    }
+  }
+  exited_.push_back(std::this_thread::get_id());
+}
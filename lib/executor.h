@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "task.h"
+#include "thread_pool.h"
+
+// Where a ready task runs. The scheduler calls Submit once per run, outside
+// its lock; the job reports completion back to the scheduler itself, so any
+// executor can feed dependents on any other.
+class Executor {
+public:
+  virtual ~Executor() = default;
+
+  virtual void Submit(Function<void> job, JobOptions options) = 0;
+
+  // Queues a job that a running one spawned as its child.
+  virtual void Spawn(Function<void> job, JobOptions options) {
+    Submit(std::move(job), options);
+  }
+};
+
+// Runs jobs on the submitting thread. Jobs submitted while one is running
+// are queued and run after it, so long chains do not grow the stack.
+class InlineExecutor : public Executor {
+public:
+  void Submit(Function<void> job, JobOptions options) override;
+
+  static std::shared_ptr<InlineExecutor> Instance();
+};
+
+class CpuExecutor : public Executor {
+public:
+  explicit CpuExecutor(std::shared_ptr<ThreadPool> pool) : pool_(std::move(pool)) {}
+
+  void Submit(Function<void> job, JobOptions options) override {
+    pool_->Submit(std::move(job), options);
+  }
+
+  void Spawn(Function<void> job, JobOptions options) override {
+    pool_->Spawn(std::move(job), options);
+  }
+
+  const std::shared_ptr<ThreadPool>& Pool() const { return pool_; }
+
+private:
+  std::shared_ptr<ThreadPool> pool_;
+};
+
+struct BlockingExecutorOptions {
+  size_t max_threads = 64;
+  std::chrono::steady_clock::duration keep_alive = std::chrono::seconds(1);
+};
+
+// Elastic pool for jobs that block: a thread is started whenever queued jobs
+// outnumber idle threads, up to max_threads, and exits after keep_alive
+// without work.
+class BlockingExecutor : public Executor {
+public:
+  BlockingExecutor() : BlockingExecutor(BlockingExecutorOptions{}) {}
+
+  explicit BlockingExecutor(BlockingExecutorOptions options) : options_(options) {}
+
+  BlockingExecutor(const BlockingExecutor&) = delete;
+  BlockingExecutor& operator=(const BlockingExecutor&) = delete;
+
+  ~BlockingExecutor() override;
+
+  void Submit(Function<void> job, JobOptions options) override;
+
+  size_t Threads();
+
+private:
+  void Loop();
+
+  BlockingExecutorOptions options_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Function<void>> jobs_;
+  std::unordered_map<std::thread::id, std::thread> threads_;
+  std::vector<std::thread::id> exited_;
+  size_t idle_ = 0;
+  bool stopping_ = false;
+};
@@ -0,0 +1,385 @@
+#include "file_io.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SCHEDULER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// Largest single read or write; the kernel caps one call just below 2 GiB.
+constexpr size_t kMaxChunk = size_t{1} << 30;
+
+}
+
+#ifdef SCHEDULER_IO_URING
+
+// A raw io_uring: liburing is not a dependency. Submitters append entries
+// under the mutex and one of them at a time enters the kernel for everything
+// appended so far, so concurrent submits share a syscall. The reaper thread
+// sleeps in the kernel until completions arrive.
+class FileIo::Ring {
+public:
+  static std::unique_ptr<Ring> Create(unsigned entries) {
+    io_uring_params params{};
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return nullptr;
+    }
+    // IORING_OP_READ and IORING_OP_WRITE arrived together with this flag.
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    std::unique_ptr<Ring> ring(new Ring(fd, params));
+    if (!ring->Map(params)) {
+      return nullptr;
+    }
+    ring->reaper_ = std::thread([ring = ring.get()] { ring->Reap(); });
+    return ring;
+  }
+
+  ~Ring() {
+    if (reaper_.joinable()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      Push(nullptr);
+      Flush(lock);
+      lock.unlock();
+      reaper_.join();
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    close(fd_);
+  }
+
+  void Submit(FileRequest* request) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (in_flight_ == entries_) {
+      backlog_.push_back(request);
+      return;
+    }
+    Push(request);
+    Flush(lock);
+  }
+
+private:
+  Ring(int fd, const io_uring_params& params) : fd_(fd), entries_(params.sq_entries) {}
+
+  bool Map(const io_uring_params& params) {
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                   IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ptr_ = single ? sq_ptr_
+                     : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                 IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+
+    auto* sq = static_cast<char*>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  // Appends the next step of `request`, or a no-op that stops the reaper.
+  // Never overfills: entries in the ring are always fewer than in_flight_.
+  void Push(FileRequest* request) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe& sqe = static_cast<io_uring_sqe*>(sqes_)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    if (request == nullptr) {
+      sqe.opcode = IORING_OP_NOP;
+    } else {
+      sqe.opcode = request->write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe.fd = request->fd;
+      sqe.addr = reinterpret_cast<uint64_t>(request->data + request->done);
+      sqe.len = static_cast<uint32_t>(std::min(request->size - request->done, kMaxChunk));
+      sqe.off = request->done;
+    }
+    sqe.user_data = reinterpret_cast<uint64_t>(request);
+    sq_array_[index] = index;
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1, std::memory_order_release);
+    ++in_flight_;
+    ++unsubmitted_;
+  }
+
+  // Hands the appended entries to the kernel unless another thread already
+  // is; that thread picks up whatever was appended while it was inside.
+  void Flush(std::unique_lock<std::mutex>& lock) {
+    if (submitting_) {
+      return;
+    }
+    submitting_ = true;
+    while (unsubmitted_ > 0) {
+      unsigned count = unsubmitted_;
+      lock.unlock();
+      int submitted = static_cast<int>(syscall(__NR_io_uring_enter, fd_, count, 0, 0, nullptr, 0));
+      int error = errno;
+      lock.lock();
+      if (submitted >= 0) {
+        unsubmitted_ -= static_cast<unsigned>(submitted);
+      } else if (error == EINTR || error == EAGAIN || error == EBUSY) {
+        std::this_thread::yield();
+      } else {
+        submitting_ = false;
+        throw std::system_error(error, std::generic_category(), "io_uring_enter");
+      }
+    }
+    submitting_ = false;
+  }
+
+  void Reap() {
+    std::vector<FileRequest*> finished;
+    bool stopping = false;
+    while (!stopping) {
+      syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      unsigned head = *cq_head_;
+      unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+      for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        auto* request = reinterpret_cast<FileRequest*>(cqe.user_data);
+        --in_flight_;
+        if (request == nullptr) {
+          stopping = true;
+          continue;
+        }
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+          Push(request);
+          continue;
+        }
+        if (cqe.res < 0) {
+          request->error = -cqe.res;
+        } else if (cqe.res == 0) {
+          // End of file for a read; a write that makes no progress is stuck.
+          if (request->write) {
+            request->error = EIO;
+          }
+        } else {
+          request->done += static_cast<size_t>(cqe.res);
+          if (request->done < request->size) {
+            Push(request);
+            continue;
+          }
+        }
+        finished.push_back(request);
+      }
+      std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+
+      while (!backlog_.empty() && in_flight_ < entries_) {
+        Push(backlog_.front());
+        backlog_.pop_front();
+      }
+      Flush(lock);
+      lock.unlock();
+
+      for (FileRequest* request : finished) {
+        Function<void> completion = std::move(request->completion);
+        completion();
+      }
+      finished.clear();
+    }
+  }
+
+  int fd_;
+  unsigned entries_;
+  void* sq_ptr_ = MAP_FAILED;
+  void* cq_ptr_ = MAP_FAILED;
+  void* sqes_ = MAP_FAILED;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  std::mutex mutex_;
+  unsigned in_flight_ = 0;
+  unsigned unsubmitted_ = 0;
+  bool submitting_ = false;
+  std::deque<FileRequest*> backlog_;
+  std::thread reaper_;
+};
+
+#else
+
+class FileIo::Ring {
+public:
+  static std::unique_ptr<Ring> Create(unsigned) { return nullptr; }
+
+  void Submit(FileRequest*) {}
+};
+
+#endif
+
+FileIo::FileIo(FileIoOptions options) {
+  if (options.use_io_uring) {
+    ring_ = Ring::Create(std::max(options.queue_depth, 1u));
+  }
+  if (!ring_) {
+    threads_ = std::make_unique<BlockingExecutor>(options.fallback);
+  }
+}
+
+FileIo::~FileIo() = default;
+
+void FileIo::Submit(FileRequest* request) {
+  if (ring_) {
+    ring_->Submit(request);
+    return;
+  }
+  threads_->Submit([request] {
+    Transfer(*request);
+    Function<void> completion = std::move(request->completion);
+    completion();
+  }, JobOptions{});
+}
+
+void FileIo::Transfer(FileRequest& request) {
+  while (request.done < request.size) {
+    size_t chunk = std::min(request.size - request.done, kMaxChunk);
+    auto offset = static_cast<off_t>(request.done);
+    ssize_t moved = request.write ? pwrite(request.fd, request.data + request.done, chunk, offset)
+                                  : pread(request.fd, request.data + request.done, chunk, offset);
+    if (moved < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      request.error = errno;
+      return;
+    }
+    if (moved == 0) {
+      if (request.write) {
+        request.error = EIO;
+      }
+      return;
+    }
+    request.done += static_cast<size_t>(moved);
+  }
+}
+
+FileTransfer::~FileTransfer() {
+  if (request_.fd >= 0) {
+    close(request_.fd);
+  }
+}
+
+void FileTransfer::Submit(Function<void> job, JobOptions) {
+  started_ = true;
+  if (!Open() || request_.size == 0) {
+    job();
+    return;
+  }
+  request_.completion = std::move(job);
+  io_->Submit(&request_);
+}
+
+Buffer FileTransfer::TakeBuffer() {
+  if (!started_ && Open()) {
+    FileIo::Transfer(request_);
+  }
+  Finish();
+  buffer_.truncate(request_.done);
+  return std::move(buffer_);
+}
+
+size_t FileTransfer::Written() {
+  if (!started_ && Open()) {
+    FileIo::Transfer(request_);
+  }
+  Finish();
+  return request_.done;
+}
+
+bool FileTransfer::Open() {
+  request_.done = 0;
+  request_.error = 0;
+  request_.write = source_ != nullptr;
+  if (request_.write) {
+    request_.fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  } else {
+    request_.fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+  if (request_.fd < 0) {
+    request_.error = errno;
+    return false;
+  }
+
+  if (request_.write) {
+    request_.data = const_cast<std::byte*>(source_->data());
+    request_.size = source_->size();
+    return true;
+  }
+  struct stat info;
+  if (fstat(request_.fd, &info) != 0) {
+    request_.error = errno;
+    return false;
+  }
+  buffer_ = Buffer(static_cast<size_t>(info.st_size));
+  request_.data = buffer_.data();
+  request_.size = buffer_.size();
+  return true;
+}
+
+// Closes the file and readies the transfer to run again after a reset.
+void FileTransfer::Finish() {
+  started_ = false;
+  if (request_.fd >= 0) {
+    close(request_.fd);
+    request_.fd = -1;
+  }
+  if (request_.error != 0) {
+    throw std::system_error(request_.error, std::generic_category(), path_);
+  }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "executor.h"
+#include "task.h"
+
+// Owned bytes. Allocation leaves them uninitialized so a read fills them once.
+class Buffer {
+public:
+  Buffer() = default;
+
+  explicit Buffer(size_t size)
+      : data_(std::make_unique_for_overwrite<std::byte[]>(size)), size_(size) {}
+
+  explicit Buffer(std::string_view text) : Buffer(text.size()) {
+    std::memcpy(data_.get(), text.data(), text.size());
+  }
+
+  std::byte* data() { return data_.get(); }
+  const std::byte* data() const { return data_.get(); }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  std::string_view view() const {
+    return std::string_view(reinterpret_cast<const char*>(data_.get()), size_);
+  }
+
+  // Drops the bytes past `size`, as when a file shrank while it was read.
+  void truncate(size_t size) { size_ = std::min(size_, size); }
+
+private:
+  std::unique_ptr<std::byte[]> data_;
+  size_t size_ = 0;
+};
+
+template <>
+struct ResultSerializer<Buffer> {
+  static constexpr bool kSpillable = true;
+
+  static size_t Size(const Buffer& value) { return value.size(); }
+
+  static void Save(const Buffer& value, std::byte* out) {
+    std::memcpy(out, value.data(), value.size());
+  }
+
+  static Buffer Load(const std::byte* in, size_t size) {
+    Buffer value(size);
+    std::memcpy(value.data(), in, size);
+    return value;
+  }
+};
+
+struct FileIoOptions {
+  // Requests in flight on the ring at once; later ones queue behind them.
+  unsigned queue_depth = 128;
+  // Off forces the thread fallback, which is also used when the kernel does
+  // not offer io_uring.
+  bool use_io_uring = true;
+  BlockingExecutorOptions fallback;
+};
+
+// A positioned transfer of `size` bytes from offset 0. FileIo moves them in
+// as many steps as the kernel needs, then calls the completion.
+struct FileRequest {
+  int fd = -1;
+  bool write = false;
+  std::byte* data = nullptr;
+  size_t size = 0;
+  // Bytes moved so far; short of `size` after a read that hit end of file.
+  size_t done = 0;
+  // errno of the failure, or 0.
+  int error = 0;
+  Function<void> completion;
+};
+
+// Asynchronous file I/O. On Linux requests are batched onto an io_uring and
+// a reaper thread handles the completions; elsewhere, or when the ring
+// cannot be set up, a BlockingExecutor runs them with pread and pwrite.
+class FileIo {
+public:
+  FileIo() : FileIo(FileIoOptions{}) {}
+
+  explicit FileIo(FileIoOptions options);
+
+  FileIo(const FileIo&) = delete;
+  FileIo& operator=(const FileIo&) = delete;
+
+  // Requests still in flight must finish first.
+  ~FileIo();
+
+  // Starts the transfer. The completion runs on an I/O thread, and once it
+  // is called FileIo does not touch the request again.
+  void Submit(FileRequest* request);
+
+  bool UsesRing() const { return ring_ != nullptr; }
+
+  // Moves the bytes on the calling thread.
+  static void Transfer(FileRequest& request);
+
+private:
+  class Ring;
+
+  std::unique_ptr<Ring> ring_;
+  std::unique_ptr<BlockingExecutor> threads_;
+};
+
+// The I/O behind a read or write task. It doubles as the task's executor:
+// submitting the task opens the file and starts the transfer, and the task
+// itself runs on the completion thread only to hand over the outcome.
+class FileTransfer : public Executor {
+public:
+  // Reads `path` whole.
+  FileTransfer(std::string path, std::shared_ptr<FileIo> io)
+      : path_(std::move(path)), io_(std::move(io)) {}
+
+  // Writes `*source` to `path`, replacing its contents. The buffer must hold
+  // its final bytes by the time the transfer is submitted.
+  FileTransfer(std::string path, const Buffer* source, std::shared_ptr<FileIo> io)
+      : path_(std::move(path)), source_(source), io_(std::move(io)) {}
+
+  FileTransfer(const FileTransfer&) = delete;
+  FileTransfer& operator=(const FileTransfer&) = delete;
+
+  ~FileTransfer() override;
+
+  void Submit(Function<void> job, JobOptions options) override;
+
+  // The outcome of a read or a write; throws std::system_error if it failed.
+  // A transfer that was never submitted runs on the calling thread.
+  Buffer TakeBuffer();
+  size_t Written();
+
+private:
+  bool Open();
+  void Finish();
+
+  std::string path_;
+  const Buffer* source_ = nullptr;
+  std::shared_ptr<FileIo> io_;
+  Buffer buffer_;
+  FileRequest request_;
+  bool started_ = false;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "scheduler.h"
+
+struct PipelineOptions {
+  size_t window = 16;
+  bool ordered = true;
+  size_t workers = 0;
+  std::shared_ptr<ThreadPool> pool;
+};
+
+// Streams records through a graph that is wired once per window slot. The
+// builder runs the first time a slot is used and reads the record through
+// the FutureResult it is given; every later record reuses the slot's graph
+// and only resets it.
+template <typename Input, typename Output>
+class TPipeline {
+public:
+  using Builder = Function<std::shared_ptr<Task<Output>>(TTaskScheduler&, FutureResult<Input>)>;
+  using Sink = Function<void(size_t, const Output&)>;
+
+  TPipeline(Builder builder, Sink sink, PipelineOptions options = {})
+      : builder_(std::move(builder)),
+        sink_(std::move(sink)),
+        window_(options.window == 0 ? 1 : options.window),
+        ordered_(options.ordered),
+        pool_(options.pool ? std::move(options.pool)
+                           : std::make_shared<ThreadPool>(options.workers)) {}
+
+  TPipeline(const TPipeline&) = delete;
+  TPipeline& operator=(const TPipeline&) = delete;
+
+  ~TPipeline() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return running_ == 0; });
+  }
+
+  void push(Input input) {
+    deliverCompleted();
+
+    Slot* slot;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (records_.size() >= window_) {
+        done_cv_.wait(lock, [this] { return hasDeliverable(); });
+        lock.unlock();
+        deliverCompleted();
+        lock.lock();
+      }
+      slot = takeSlot();
+    }
+
+    slot->sequence = next_sequence_;
+    slot->input = std::move(input);
+    slot->done = false;
+    slot->error = nullptr;
+    if (slot->scheduler) {
+      slot->scheduler->reset();
+    } else {
+      try {
+        build(*slot);
+      } catch (...) {
+        slot->scheduler.reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(slot);
+        throw;
+      }
+    }
+    ++next_sequence_;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      records_.emplace(slot->sequence, slot);
+      ++running_;
+    }
+
+    slot->scheduler->notifyWhenDrained([this, slot](std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      slot->error = error;
+      slot->done = true;
+      if (!ordered_) {
+        completed_.push_back(slot->sequence);
+      }
+      --running_;
+      done_cv_.notify_all();
+    });
+  }
+
+  void finish() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_cv_.wait(lock, [this] { return running_ == 0; });
+    }
+    deliverCompleted();
+
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  size_t inFlight() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_.size();
+  }
+
+  // Graphs built so far; at most one per window slot.
+  size_t graphsBuilt() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return built_;
+  }
+
+private:
+  struct Slot {
+    size_t sequence = 0;
+    std::unique_ptr<TTaskScheduler> scheduler;
+    Input input;
+    Output output;
+    bool done = false;
+    std::exception_ptr error;
+  };
+
+  Builder builder_;
+  Sink sink_;
+  size_t window_;
+  bool ordered_;
+  std::shared_ptr<ThreadPool> pool_;
+
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<Slot*> free_;
+  std::unordered_map<size_t, Slot*> records_;
+  std::deque<size_t> completed_;
+  size_t next_sequence_ = 0;
+  size_t next_delivery_ = 0;
+  size_t running_ = 0;
+  size_t built_ = 0;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+
+  Slot* takeSlot() {
+    if (free_.empty()) {
+      slots_.push_back(std::make_unique<Slot>());
+      return slots_.back().get();
+    }
+    Slot* slot = free_.back();
+    free_.pop_back();
+    return slot;
+  }
+
+  // The scheduler is eager, so the first record runs while this wires it.
+  void build(Slot& slot) {
+    Slot* raw = &slot;
+    slot.scheduler = std::make_unique<TTaskScheduler>(SchedulerOptions{.pool = pool_});
+    auto source = slot.scheduler->add([raw] { return std::move(raw->input); });
+    auto target = builder_(*slot.scheduler, FutureResult<Input>(source));
+    slot.scheduler->add([raw](const Output& output) { raw->output = output; },
+                        FutureResult<Output>(target));
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++built_;
+  }
+
+  bool hasDeliverable() {
+    if (!ordered_) {
+      return !completed_.empty();
+    }
+    auto it = records_.find(next_delivery_);
+    return it != records_.end() && it->second->done;
+  }
+
+  Slot* takeDeliverable() {
+    size_t sequence = next_delivery_;
+    if (!ordered_) {
+      sequence = completed_.front();
+      completed_.pop_front();
+    } else {
+      ++next_delivery_;
+    }
+
+    auto it = records_.find(sequence);
+    Slot* slot = it->second;
+    records_.erase(it);
+    return slot;
+  }
+
+  void deliverCompleted() {
+    while (true) {
+      Slot* slot;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!hasDeliverable()) {
+          return;
+        }
+        slot = takeDeliverable();
+      }
+
+      if (slot->error) {
+        if (!error_) {
+          error_ = slot->error;
+        }
+      } else {
+        sink_(slot->sequence, slot->output);
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(slot);
+    }
+  }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "task.h"
+
+// Mean run time per callable, learned from sampled runs and shared by every
+// scheduler in the process, so a request graph built afresh each time still
+// benefits from what earlier ones measured. The table is direct-mapped and
+// lock-free; a slot taken over by another callable starts learning again, and
+// a racing update may briefly pair a site with a neighbour's mean, which only
+// costs one mispredicted placement.
+class RunCosts {
+public:
+  static constexpr size_t kSlots = 256;  // Index() yields 8 bits.
+  static constexpr uint32_t kUnknown = UINT32_MAX;
+  // Each thread times one run in kSampleEvery.
+  static constexpr uint32_t kSampleEvery = 8;
+
+  static RunCosts& Global() {
+    static RunCosts costs;
+    return costs;
+  }
+
+  void Record(TaskBase::RunFunction site, int64_t nanoseconds) {
+    Slot& slot = SlotOf(site);
+    uint32_t sample = static_cast<uint32_t>(
+        std::clamp<int64_t>(nanoseconds, 0, static_cast<int64_t>(kUnknown) - 1));
+    if (slot.site.load(std::memory_order_relaxed) != site) {
+      slot.mean_ns.store(sample, std::memory_order_relaxed);
+      slot.site.store(site, std::memory_order_release);
+      return;
+    }
+    // Exponential moving average weighting the newest run by 1/4.
+    uint32_t mean = slot.mean_ns.load(std::memory_order_relaxed);
+    slot.mean_ns.store(static_cast<uint32_t>((uint64_t{mean} * 3 + sample) / 4),
+                       std::memory_order_relaxed);
+  }
+
+  // kUnknown until a run of `site` has been timed.
+  uint32_t MeanNanoseconds(TaskBase::RunFunction site) const {
+    const Slot& slot = SlotOf(site);
+    if (slot.site.load(std::memory_order_acquire) != site) {
+      return kUnknown;
+    }
+    return slot.mean_ns.load(std::memory_order_relaxed);
+  }
+
+  // True when the calling thread should time this run.
+  static bool Sample() {
+    thread_local uint32_t runs = 0;
+    return (runs++ & (kSampleEvery - 1)) == 0;
+  }
+
+private:
+  struct alignas(16) Slot {
+    std::atomic<TaskBase::RunFunction> site{nullptr};
+    std::atomic<uint32_t> mean_ns{kUnknown};
+  };
+
+  static size_t Index(TaskBase::RunFunction site) {
+    // Fibonacci hashing: code addresses share their low bits.
+    uint64_t bits = reinterpret_cast<uintptr_t>(site);
+    return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ull) >> 56);
+  }
+
+  Slot& SlotOf(TaskBase::RunFunction site) { return slots_[Index(site)]; }
+  const Slot& SlotOf(TaskBase::RunFunction site) const { return slots_[Index(site)]; }
+
+  std::array<Slot, kSlots> slots_;
+};
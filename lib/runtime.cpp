@@ -0,0 +1,144 @@
+#include "runtime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#include "stats.h"
+
+Runtime::Runtime(RuntimeOptions options)
+    : pool_(std::make_shared<ThreadPool>(
+          ThreadPoolOptions{.workers = options.workers, .pin_workers = options.pin_workers})) {}
+
+std::shared_ptr<Runtime> Runtime::Default() {
+  static std::shared_ptr<Runtime> runtime = std::make_shared<Runtime>();
+  return runtime;
+}
+
+std::shared_ptr<Tenant> Runtime::AddTenant(std::string name, double weight) {
+  if (!(weight > 0) || !std::isfinite(weight)) {
+    throw std::invalid_argument("tenant weight must be positive and finite");
+  }
+  std::shared_ptr<Tenant> tenant(new Tenant(shared_from_this(), std::move(name), weight));
+  std::lock_guard<std::mutex> lock(mutex_);
+  tenants_.push_back(tenant.get());
+  return tenant;
+}
+
+std::vector<TenantUsage> Runtime::Usage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<TenantUsage> usage;
+  usage.reserve(tenants_.size());
+  for (const Tenant* tenant : tenants_) {
+    usage.push_back(UsageOf(*tenant));
+  }
+  return usage;
+}
+
+TenantUsage Runtime::UsageOf(const Tenant& tenant) {
+  return TenantUsage{.name = tenant.name_,
+                     .weight = tenant.weight_,
+                     .jobs = tenant.jobs_,
+                     .busy = std::chrono::nanoseconds(tenant.busy_ns_),
+                     .queued = tenant.queued_};
+}
+
+void Runtime::Enqueue(Tenant* tenant, Function<void> job, JobOptions options) {
+  int level = std::clamp(options.priority, 0, ThreadPool::kPriorityLevels - 1);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& queue = tenant->queues_[level];
+    auto position = queue.end();
+    while (position != queue.begin() && std::prev(position)->deadline > options.deadline) {
+      --position;
+    }
+    queue.insert(position, Tenant::Job{std::move(job), options.deadline});
+    if (tenant->queued_++ == 0) {
+      tenant->virtual_time_ = std::max(tenant->virtual_time_, floor_);
+      active_.emplace(tenant->virtual_time_, tenant);
+    }
+  }
+  // Slots and queued jobs are posted and taken one for one, so a slot always
+  // finds a job and jobs never wait while a worker is free.
+  pool_->Submit([this] { RunNext(); }, JobOptions{.node = options.node});
+}
+
+void Runtime::RunNext() {
+  Tenant* tenant;
+  Function<void> job;
+  double charged;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_.empty()) {
+      return;
+    }
+    tenant = active_.begin()->second;
+    active_.erase(active_.begin());
+    floor_ = std::max(floor_, tenant->virtual_time_);
+
+    for (int level = ThreadPool::kPriorityLevels - 1; level >= 0; --level) {
+      auto& queue = tenant->queues_[level];
+      if (!queue.empty()) {
+        job = std::move(queue.front().function);
+        queue.pop_front();
+        break;
+      }
+    }
+    --tenant->queued_;
+    ++tenant->running_;
+
+    // Charge the tenant's mean run time up front so that workers picking
+    // while this job runs already see it; Account settles the difference.
+    charged = tenant->jobs_ == 0 ? 0 : static_cast<double>(tenant->busy_ns_) / tenant->jobs_;
+    tenant->virtual_time_ += charged / tenant->weight_;
+    if (tenant->queued_ > 0) {
+      active_.emplace(tenant->virtual_time_, tenant);
+    }
+  }
+
+  int64_t started = StatsNow();
+  try {
+    job();
+  } catch (...) {
+    Account(tenant, charged, StatsNow() - started);
+    throw;
+  }
+  Account(tenant, charged, StatsNow() - started);
+}
+
+void Runtime::Account(Tenant* tenant, double charged, int64_t elapsed) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool active = tenant->queued_ > 0;
+  if (active) {
+    active_.erase({tenant->virtual_time_, tenant});
+  }
+  tenant->virtual_time_ += (static_cast<double>(elapsed) - charged) / tenant->weight_;
+  if (active) {
+    active_.emplace(tenant->virtual_time_, tenant);
+  }
+  ++tenant->jobs_;
+  tenant->busy_ns_ += static_cast<uint64_t>(elapsed);
+  if (--tenant->running_ == 0 && tenant->queued_ == 0) {
+    drained_cv_.notify_all();
+  }
+}
+
+void Runtime::Remove(Tenant* tenant) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  drained_cv_.wait(lock, [tenant] { return tenant->queued_ == 0 && tenant->running_ == 0; });
+  tenants_.erase(std::find(tenants_.begin(), tenants_.end(), tenant));
+}
+
+Tenant::~Tenant() {
+  runtime_->Remove(this);
+}
+
+void Tenant::Submit(Function<void> job, JobOptions options) {
+  runtime_->Enqueue(this, std::move(job), options);
+}
+
+TenantUsage Tenant::Usage() {
+  std::lock_guard<std::mutex> lock(runtime_->mutex_);
+  return Runtime::UsageOf(*this);
+}
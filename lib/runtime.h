@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "executor.h"
+#include "task.h"
+#include "thread_pool.h"
+
+struct RuntimeOptions {
+  size_t workers = 0;
+  bool pin_workers = false;
+};
+
+struct TenantUsage {
+  std::string name;
+  double weight = 1;
+  uint64_t jobs = 0;
+  // Wall time spent in the tenant's jobs.
+  std::chrono::nanoseconds busy{0};
+  size_t queued = 0;
+};
+
+class Tenant;
+
+// One worker pool shared by many schedulers, each submitting through a Tenant
+// of its own. Every submit queues the job with its tenant and posts a slot to
+// the pool; a worker that takes a slot runs the next job of the tenant with
+// the least run time per unit of weight. A large batch graph therefore takes
+// only its share of the workers, and a small interactive one starts at once.
+// Create it with std::make_shared.
+class Runtime : public std::enable_shared_from_this<Runtime> {
+public:
+  explicit Runtime(RuntimeOptions options = {});
+
+  Runtime(const Runtime&) = delete;
+  Runtime& operator=(const Runtime&) = delete;
+
+  // The process-wide runtime, with one worker per CPU.
+  static std::shared_ptr<Runtime> Default();
+
+  // A tenant gets `weight` times the share of a weight-1 tenant while both
+  // have work queued. Throws std::invalid_argument unless `weight` is
+  // positive and finite.
+  std::shared_ptr<Tenant> AddTenant(std::string name, double weight = 1);
+
+  // Live tenants, in the order they were added.
+  std::vector<TenantUsage> Usage();
+
+  const std::shared_ptr<ThreadPool>& Pool() const { return pool_; }
+
+private:
+  friend class Tenant;
+
+  void Enqueue(Tenant* tenant, Function<void> job, JobOptions options);
+  void RunNext();
+  void Account(Tenant* tenant, double charged, int64_t elapsed);
+  void Remove(Tenant* tenant);
+  static TenantUsage UsageOf(const Tenant& tenant);
+
+  std::shared_ptr<ThreadPool> pool_;
+  std::mutex mutex_;
+  std::condition_variable drained_cv_;
+  std::vector<Tenant*> tenants_;
+  // Tenants with queued jobs, by virtual time.
+  std::set<std::pair<double, Tenant*>> active_;
+  // Virtual time of the last tenant picked. A tenant that was idle resumes
+  // from here rather than cashing in the time it did not use.
+  double floor_ = 0;
+};
+
+// A scheduler's handle on a Runtime; pass it as SchedulerOptions::tenant.
+// Destruction waits for the jobs already submitted.
+class Tenant : public Executor {
+public:
+  Tenant(const Tenant&) = delete;
+  Tenant& operator=(const Tenant&) = delete;
+
+  ~Tenant() override;
+
+  void Submit(Function<void> job, JobOptions options) override;
+
+  TenantUsage Usage();
+
+  const std::shared_ptr<ThreadPool>& Pool() const { return runtime_->Pool(); }
+
+private:
+  friend class Runtime;
+
+  struct Job {
+    Function<void> function;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  Tenant(std::shared_ptr<Runtime> runtime, std::string name, double weight)
+      : runtime_(std::move(runtime)), name_(std::move(name)), weight_(weight) {}
+
+  std::shared_ptr<Runtime> runtime_;
+  std::string name_;
+  double weight_;
+
+  // Guarded by the runtime's mutex.
+  std::array<std::deque<Job>, ThreadPool::kPriorityLevels> queues_;
+  size_t queued_ = 0;
+  size_t running_ = 0;
+  double virtual_time_ = 0;
+  uint64_t jobs_ = 0;
+  uint64_t busy_ns_ = 0;
+};
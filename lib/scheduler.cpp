@@ -1,18 +1,463 @@
 #include "scheduler.h"
+#include "run_costs.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <queue>
 #include <unordered_map>
 #include <stdexcept>
 
+namespace {
+
+// Task-level edges between positions in a task list, without duplicates.
+struct PositionGraph {
+  std::vector<std::vector<size_t>> inputs;
+  std::vector<std::vector<size_t>> readers;
+
+  static PositionGraph Of(const std::vector<std::shared_ptr<TaskBase>>& tasks) {
+    std::unordered_map<TaskBase*, size_t> index;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      index[tasks[i].get()] = i;
+    }
+    PositionGraph graph{std::vector<std::vector<size_t>>(tasks.size()),
+                        std::vector<std::vector<size_t>>(tasks.size())};
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      std::vector<size_t>& inputs = graph.inputs[i];
+      for (auto& dep : tasks[i]->GetDependecies()) {
+        inputs.push_back(index[dep.get()]);
+      }
+      std::sort(inputs.begin(), inputs.end());
+      inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+      for (size_t input : inputs) {
+        graph.readers[input].push_back(i);
+      }
+    }
+    return graph;
+  }
+};
+
+}
+
+TTaskScheduler::TTaskScheduler(SchedulerOptions options) {
+  if (options.tenant) {
+    pool_ = options.tenant->Pool();
+    executor_ = std::move(options.tenant);
+  } else if (options.pool) {
+    pool_ = std::move(options.pool);
+  } else if (options.eager) {
+    pool_ = std::make_shared<ThreadPool>(ThreadPoolOptions{.workers = options.workers,
+                                                           .pin_workers = options.pin_workers,
+                                                           .spin = options.latency.spin});
+  }
+  if (pool_ && !executor_) {
+    executor_ = std::make_shared<CpuExecutor>(pool_);
+  }
+  if (options.latency.Enabled() && !pool_) {
+    throw std::logic_error("Low-latency options require an eager scheduler");
+  }
+  // A tenant's jobs must pass through its runtime to be accounted for.
+  if (!options.tenant) {
+    inline_continuations_ = options.latency.inline_continuations;
+    inline_below_ns_ = options.latency.inline_below.count();
+  }
+  file_io_ = std::move(options.file_io);
+  if (options.minimize_peak_memory && pool_) {
+    throw std::logic_error("Memory-aware ordering requires a serial scheduler");
+  }
+  minimize_peak_memory_ = options.minimize_peak_memory;
+  if (options.result_budget != 0) {
+    if (pool_) {
+      throw std::logic_error("Result spilling requires a serial scheduler");
+    }
+    result_budget_ = options.result_budget;
+    spill_file_ = std::make_shared<SpillFile>(
+        options.spill_directory.empty() ? std::filesystem::temp_directory_path().string()
+                                        : options.spill_directory);
+  }
+  memory_budget_ = options.memory_budget;
+  resource_limits_ = std::move(options.resource_limits);
+  if (options.watchdog.Enabled()) {
+    watchdog_ = std::make_unique<Watchdog>(generation_, std::move(options.watchdog));
+    timers_ = std::make_unique<TimerService>();
+    timers_->Schedule(std::chrono::steady_clock::now() + watchdog_->Interval(),
+                      [this] { checkStragglers(); });
+  }
+}
+
+TTaskScheduler::~TTaskScheduler() {
+  if (timers_) {
+    timers_->Stop();
+
+    std::vector<std::pair<uint32_t, std::exception_ptr>> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (uint32_t id : timed_) {
+        if (dropTimer(id)) {
+          cancelled.emplace_back(id, states_[id].error);
+        }
+      }
+    }
+    for (auto& [id, error] : cancelled) {
+      finishTask(id, error);
+    }
+  }
+
+  if (pool_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_cv_.wait(lock, [this] { return outstanding_ == 0 && dispatching_ == 0; });
+  }
+
+  for (TaskBase* task : by_id_) {
+    task->unbindStatus();
+  }
+}
+
 void TTaskScheduler::executeAll() {
-  try {
-    TopSort();
-    for (auto& task : tasks_) {
-      task->Execute();
+  if (pool_) {
+    waitForAll();
+    return;
+  }
+
+  StatsShard* shard = localStats();
+  int64_t started = shard ? StatsNow() : 0;
+  uint64_t task_ns = shard ? shard->TaskNanoseconds() : 0;
+
+  ensureOrder();
+  for (; run_from_ < table_.size(); ++run_from_) {
+    const TaskSlot& slot = table_[run_from_];
+    if ((slot.status->load(std::memory_order_acquire) & TaskBase::kExecuted) == 0) {
+      runSlot(slot, shard);
     }
-  } catch(...) {
-    throw;
+  }
+
+  if (shard) {
+    shard->RecordOverhead(StatsNow() - started - (shard->TaskNanoseconds() - task_ns));
+  }
+}
+
+void TTaskScheduler::runSlot(const TaskSlot& slot, StatsShard* shard) {
+  uint32_t id = watchdog_ || spill_file_ || minimize_peak_memory_ ? findTask(slot.task) : kNoTask;
+  if (spill_file_ && id != kNoTask) {
+    running_ = id;
+    restoreResults(states_[id].inputs);
+  }
+  {
+    Watchdog::Scope watch(id != kNoTask ? watchdog_.get() : nullptr, slot.task->id_, slot.run);
+    try {
+      if (!shard) {
+        slot.run(slot.task);
+      } else {
+        RunTimer timer(*shard);
+        slot.run(slot.task);
+        timer.Succeeded();
+      }
+    } catch (...) {
+      running_ = kNoTask;
+      throw;
+    }
+    running_ = kNoTask;
+  }
+  if (id == kNoTask) {
+    return;
+  }
+  if (minimize_peak_memory_) {
+    trackLiveness(id);
+  }
+  if (spill_file_) {
+    trackResult(id);
+  }
+}
+
+void TTaskScheduler::addDataEdge(uint32_t from, uint32_t to) {
+  std::vector<uint32_t>& inputs = states_[to].inputs;
+  if (std::find(inputs.begin(), inputs.end(), from) == inputs.end()) {
+    inputs.push_back(from);
+    states_[from].readers.push_back(to);
+  }
+}
+
+// A result read outside the run loop, as through getResult() or an input the
+// graph does not show, comes back through the same accounting.
+void TTaskScheduler::Restore(TaskBase* task) {
+  uint32_t id = findTask(task);
+  if (id == kNoTask || id >= result_bytes_.size()) {
+    task->RestoreResult();
+    return;
+  }
+  restoreResults({id});
+}
+
+// Makes room before reading the results back, so only `ids` and the inputs
+// of the running task may take residency past the budget.
+void TTaskScheduler::restoreResults(const std::vector<uint32_t>& ids) {
+  size_t restoring = 0;
+  for (uint32_t id : ids) {
+    if (by_id_[id]->IsSpilled()) {
+      restoring += result_bytes_[id];
+    }
+  }
+  if (restoring == 0) {
+    return;
+  }
+  resident_bytes_ += restoring;
+  if (resident_bytes_ > result_budget_) {
+    spillResults(ids);
+  }
+  for (uint32_t id : ids) {
+    TaskBase* input = by_id_[id];
+    if (!input->IsSpilled()) {
+      continue;
+    }
+    input->RestoreResult();
+    resident_.push_back(id);
+    ++results_restored_;
+  }
+}
+
+// Follows the model MemorySort plans with: a result is live from its run
+// until every task reading it has run, over the data edges that
+// reduceGraph leaves alone.
+void TTaskScheduler::trackLiveness(uint32_t id) {
+  if (live_bytes_.size() < by_id_.size()) {
+    live_bytes_.resize(by_id_.size());
+  }
+  live_bytes_[id] = by_id_[id]->ResultFootprint();
+  live_total_ += live_bytes_[id];
+  live_peak_ = std::max(live_peak_, live_total_);
+
+  auto release_if_read = [this](uint32_t producer) {
+    if (live_bytes_[producer] == 0) {
+      return;
+    }
+    for (uint32_t reader : states_[producer].readers) {
+      if (!hasStatus(reader, TaskBase::kExecuted)) {
+        return;
+      }
+    }
+    live_total_ -= live_bytes_[producer];
+    live_bytes_[producer] = 0;
+  };
+  for (uint32_t dependency : states_[id].inputs) {
+    release_if_read(dependency);
+  }
+  release_if_read(id);
+}
+
+void TTaskScheduler::trackResult(uint32_t id) {
+  size_t bytes = by_id_[id]->ResultBytes();
+  if (bytes == 0) {
+    return;
+  }
+  if (result_bytes_.size() < by_id_.size()) {
+    result_bytes_.resize(by_id_.size());
+  }
+  result_bytes_[id] = bytes;
+  resident_.push_back(id);
+  resident_bytes_ += bytes;
+  if (resident_bytes_ > result_budget_) {
+    spillResults({});
+  }
+}
+
+// Belady's rule over the known order: spill the results whose next reader
+// runs furthest ahead, and first those that no pending task reads at all,
+// until the rest fit the budget. `pinned` and the running task's inputs stay
+// resident.
+void TTaskScheduler::spillResults(const std::vector<uint32_t>& pinned) {
+  std::vector<std::pair<uint32_t, uint32_t>> by_next_use;
+  by_next_use.reserve(resident_.size());
+  for (uint32_t id : resident_) {
+    uint32_t next_use = UINT32_MAX;
+    for (uint32_t dependent : states_[id].readers) {
+      if (!hasStatus(dependent, TaskBase::kExecuted)) {
+        next_use = std::min(next_use, ord_[dependent]);
+      }
+    }
+    by_next_use.emplace_back(next_use, id);
+  }
+  std::sort(by_next_use.begin(), by_next_use.end(), std::greater<>());
+
+  resident_.clear();
+  auto is_pinned = [this, &pinned](uint32_t id) {
+    if (std::find(pinned.begin(), pinned.end(), id) != pinned.end()) {
+      return true;
+    }
+    if (running_ == kNoTask) {
+      return false;
+    }
+    const std::vector<uint32_t>& inputs = states_[running_].inputs;
+    return std::find(inputs.begin(), inputs.end(), id) != inputs.end();
+  };
+  for (auto [next_use, id] : by_next_use) {
+    if (resident_bytes_ <= result_budget_ || is_pinned(id)) {
+      resident_.push_back(id);
+      continue;
+    }
+    by_id_[id]->SpillResult(spill_file_);
+    resident_bytes_ -= result_bytes_[id];
+    bytes_spilled_ += result_bytes_[id];
+    ++results_spilled_;
+  }
+}
+
+bool TTaskScheduler::executeAll(std::chrono::steady_clock::duration timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  if (pool_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!finished_cv_.wait_until(lock, deadline, [this] { return outstanding_ == 0; })) {
+      return false;
+    }
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return true;
+  }
+
+  ensureOrder();
+  for (; run_from_ < table_.size(); ++run_from_) {
+    const TaskSlot& slot = table_[run_from_];
+    if ((slot.status->load(std::memory_order_acquire) & TaskBase::kExecuted) != 0) {
+      continue;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    runSlot(slot, localStats());
+  }
+  return true;
+}
+
+void TTaskScheduler::reset() {
+  if (!pool_) {
+    for (size_t id = 0; id < status_.Size(); ++id) {
+      status_[id].fetch_and(static_cast<uint8_t>(~TaskBase::kExecuted), std::memory_order_release);
+    }
+    if (spill_file_) {
+      for (TaskBase* task : by_id_) {
+        task->DropSpill();
+      }
+      resident_.clear();
+      resident_bytes_ = 0;
+    }
+    live_bytes_.assign(live_bytes_.size(), 0);
+    live_total_ = 0;
+    live_peak_ = 0;
+    // Plan the next run with the sizes this one measured.
+    if (minimize_peak_memory_) {
+      order_valid_ = false;
+    }
+    run_from_ = 0;
+    return;
+  }
+
+  std::vector<ReadyTask> ready;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_cv_.wait(lock, [this] { return outstanding_ == 0; });
+    if (!timed_.empty()) {
+      throw std::logic_error("reset() does not support timer tasks");
+    }
+
+    error_ = nullptr;
+    for (uint32_t id = 0; id < by_id_.size(); ++id) {
+      clearStatus(id, TASK_FINISHED | TaskBase::kExecuted);
+      states_[id].error = nullptr;
+      pending_[id] = static_cast<uint32_t>(states_[id].dependencies.size());
+    }
+    outstanding_ = by_id_.size();
+    for (uint32_t id = 0; id < by_id_.size(); ++id) {
+      if (pending_[id] == 0) {
+        makeReady(id, ready);
+      }
+    }
+  }
+
+  for (const ReadyTask& next : ready) {
+    dispatch(next);
   }
 }
 
+GraphReduction TTaskScheduler::reduceGraph() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pool_) {
+    finished_cv_.wait(lock, [this] { return outstanding_ == 0; });
+  }
+  ensureOrder();
+
+  GraphReduction report;
+  std::vector<uint32_t> stamp(by_id_.size(), 0);
+  std::vector<uint32_t> stack;
+  for (uint32_t id = 0; id < by_id_.size(); ++id) {
+    std::vector<uint32_t>& deps = states_[id].dependencies;
+    if (deps.size() < 2) {
+      continue;
+    }
+
+    // Latest dependency first: an earlier one is redundant exactly when it
+    // is reachable backwards from a later one.
+    std::sort(deps.begin(), deps.end(), [this](uint32_t lhs, uint32_t rhs) {
+      return ord_[lhs] > ord_[rhs];
+    });
+    uint32_t lowest = ord_[deps.back()];
+    uint32_t mark = id + 1;
+
+    size_t kept = 0;
+    uint32_t previous = kNoTask;
+    for (size_t i = 0; i < deps.size(); ++i) {
+      uint32_t dep = deps[i];
+      bool duplicate = dep == previous;
+      previous = dep;
+      if (stamp[dep] == mark) {
+        ++(duplicate ? report.duplicate_edges : report.transitive_edges);
+        continue;
+      }
+      deps[kept++] = dep;
+      stamp[dep] = mark;
+
+      stack.assign(states_[dep].dependencies.begin(), states_[dep].dependencies.end());
+      while (!stack.empty()) {
+        uint32_t current = stack.back();
+        stack.pop_back();
+        if (stamp[current] == mark || ord_[current] < lowest) {
+          continue;
+        }
+        stamp[current] = mark;
+        for (uint32_t next : states_[current].dependencies) {
+          stack.push_back(next);
+        }
+      }
+    }
+    deps.resize(kept);
+  }
+
+  reduced_ = true;
+  for (TaskState& state : states_) {
+    state.dependents.clear();
+  }
+  for (uint32_t id = 0; id < by_id_.size(); ++id) {
+    for (uint32_t dep : states_[id].dependencies) {
+      states_[dep].dependents.push_back(id);
+    }
+  }
+  return report;
+}
+
+void TTaskScheduler::ensureOrder() {
+  uint64_t epoch = edge_epoch_.load(std::memory_order_relaxed);
+  if (order_valid_ && order_epoch_ == epoch) {
+    return;
+  }
+  StatsShard* shard = localStats();
+  int64_t started = shard ? StatsNow() : 0;
+  TopSort();
+  if (shard) {
+    shard->RecordTopSort(StatsNow() - started);
+  }
+  order_valid_ = true;
+  order_epoch_ = epoch;
+}
+
 void TTaskScheduler::TopSort() {
   std::vector<std::shared_ptr<TaskBase>> vec;
   
@@ -30,9 +475,353 @@ void TTaskScheduler::TopSort() {
   
   
   
+  tasks_ = std::move(vec);
+
+  if (minimize_peak_memory_) {
+    MemorySort();
+  } else if (prioritized_) {
+    PrioritySort();
+  }
+  buildTable();
+}
+
+void TTaskScheduler::buildTable() {
+  table_.clear();
+  table_.reserve(tasks_.size());
+  for (auto& task : tasks_) {
+    uint32_t id = findTask(task.get());
+    if (id != kNoTask) {
+      ord_[id] = static_cast<uint32_t>(table_.size());
+    }
+    table_.push_back(TaskSlot{task->run_, task.get(), task->status_});
+  }
+  run_from_ = 0;
+}
+
+void TTaskScheduler::addDependency(const std::shared_ptr<TaskBase>& task,
+                                   const std::shared_ptr<TaskBase>& dependency) {
+  if (pool_) {
+    throw std::logic_error("addDependency() requires a serial scheduler");
+  }
+  uint32_t to = findTask(task.get());
+  uint32_t from = findTask(dependency.get());
+  if (to == kNoTask || from == kNoTask) {
+    throw std::invalid_argument("Both tasks must belong to this scheduler");
+  }
+
+  if (has_foreign_ || prioritized_ || minimize_peak_memory_) {
+    task->dependencies_.push_back(dependency);
+    order_valid_ = false;
+    try {
+      ensureOrder();
+    } catch (...) {
+      task->dependencies_.pop_back();
+      order_valid_ = false;
+      throw;
+    }
+  } else {
+    ensureOrder();
+    insertEdge(from, to);
+    task->dependencies_.push_back(dependency);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  states_[to].dependencies.push_back(from);
+  states_[from].dependents.push_back(to);
+  addDataEdge(from, to);
+}
+
+// Pearce-Kelly: only the tasks positioned between the two endpoints are
+// visited, and only those reachable through the new edge move.
+void TTaskScheduler::insertEdge(uint32_t from, uint32_t to) {
+  if (from == to) {
+    throw std::runtime_error("Dependency cycle detected!");
+  }
+  uint32_t lower = ord_[to];
+  uint32_t upper = ord_[from];
+  if (upper < lower) {
+    return;
+  }
+
+  marks_.resize(by_id_.size(), 0);
+  std::vector<uint32_t> forward;
+  std::vector<uint32_t> backward;
+  auto clear_marks = [this, &forward, &backward] {
+    for (uint32_t id : forward) {
+      marks_[id] = 0;
+    }
+    for (uint32_t id : backward) {
+      marks_[id] = 0;
+    }
+  };
+
+  std::vector<uint32_t> stack{to};
+  marks_[to] = 1;
+  while (!stack.empty()) {
+    uint32_t current = stack.back();
+    stack.pop_back();
+    forward.push_back(current);
+    for (uint32_t dependent : states_[current].dependents) {
+      if (dependent == from) {
+        for (uint32_t id : stack) {
+          marks_[id] = 0;
+        }
+        clear_marks();
+        throw std::runtime_error("Dependency cycle detected!");
+      }
+      if (!marks_[dependent] && ord_[dependent] < upper) {
+        marks_[dependent] = 1;
+        stack.push_back(dependent);
+      }
+    }
+  }
+
+  stack.push_back(from);
+  marks_[from] = 1;
+  while (!stack.empty()) {
+    uint32_t current = stack.back();
+    stack.pop_back();
+    backward.push_back(current);
+    for (uint32_t dep_id : states_[current].dependencies) {
+      if (!marks_[dep_id] && ord_[dep_id] > lower) {
+        marks_[dep_id] = 1;
+        stack.push_back(dep_id);
+      }
+    }
+  }
+  clear_marks();
+
+  auto by_position = [this](uint32_t lhs, uint32_t rhs) { return ord_[lhs] < ord_[rhs]; };
+  std::sort(forward.begin(), forward.end(), by_position);
+  std::sort(backward.begin(), backward.end(), by_position);
+
+  std::vector<uint32_t> positions;
+  positions.reserve(forward.size() + backward.size());
+  for (uint32_t id : backward) {
+    positions.push_back(ord_[id]);
+  }
+  for (uint32_t id : forward) {
+    positions.push_back(ord_[id]);
+  }
+  std::sort(positions.begin(), positions.end());
+
+  size_t next = 0;
+  for (uint32_t id : backward) {
+    ord_[id] = positions[next++];
+    table_[ord_[id]] = slotOf(id);
+  }
+  for (uint32_t id : forward) {
+    ord_[id] = positions[next++];
+    table_[ord_[id]] = slotOf(id);
+  }
+  run_from_ = std::min<size_t>(run_from_, positions.front());
+}
+
+void TTaskScheduler::PrioritySort() {
+  std::unordered_map<TaskBase*, size_t> index;
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    index[tasks_[i].get()] = i;
+  }
+
+  std::vector<size_t> indegree(tasks_.size(), 0);
+  std::vector<std::vector<size_t>> dependents(tasks_.size());
+  std::vector<std::pair<int, std::chrono::steady_clock::time_point>> keys(tasks_.size());
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    uint32_t id = reduced_ && !has_foreign_ ? findTask(tasks_[i].get()) : kNoTask;
+    if (id != kNoTask) {
+      for (uint32_t dep : states_[id].dependencies) {
+        dependents[index[by_id_[dep]]].push_back(i);
+        ++indegree[i];
+      }
+    } else {
+      for (auto& dep : tasks_[i]->GetDependecies()) {
+        dependents[index[dep.get()]].push_back(i);
+        ++indegree[i];
+      }
+    }
+    keys[i] = orderKey(tasks_[i].get());
+  }
+
+  auto later = [&keys](size_t lhs, size_t rhs) {
+    if (keys[lhs].first != keys[rhs].first) {
+      return keys[lhs].first < keys[rhs].first;
+    }
+    if (keys[lhs].second != keys[rhs].second) {
+      return keys[lhs].second > keys[rhs].second;
+    }
+    return lhs > rhs;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> ready(later);
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    if (indegree[i] == 0) {
+      ready.push(i);
+    }
+  }
+
+  std::vector<std::shared_ptr<TaskBase>> vec;
+  vec.reserve(tasks_.size());
+  while (!ready.empty()) {
+    size_t current = ready.top();
+    ready.pop();
+    vec.push_back(tasks_[current]);
+    for (size_t dependent : dependents[current]) {
+      if (--indegree[dependent] == 0) {
+        ready.push(dependent);
+      }
+    }
+  }
+
+  tasks_ = std::move(vec);
+}
+
+std::pair<int, std::chrono::steady_clock::time_point> TTaskScheduler::orderKey(
+    TaskBase* task) const {
+  uint32_t id = findTask(task);
+  if (id == kNoTask) {
+    return {0, std::chrono::steady_clock::time_point::max()};
+  }
+  return {priority_[id], states_[id].deadline};
+}
+
+size_t TTaskScheduler::predictedBytes(TaskBase* task) const {
+  uint32_t id = findTask(task);
+  if (id != kNoTask && states_[id].options.result_bytes != 0) {
+    return states_[id].options.result_bytes;
+  }
+  return task->ResultFootprint();
+}
+
+// Greedy list scheduling over the estimated result sizes: of the ready tasks,
+// run the one that grows the live results least, counting the inputs it is
+// the last reader of as freed. The most recently readied task wins ties, so
+// one branch is finished before the next is opened.
+void TTaskScheduler::MemorySort() {
+  PositionGraph graph = PositionGraph::Of(tasks_);
+  size_t count = tasks_.size();
+
+  std::vector<int64_t> bytes(count);
+  std::vector<std::pair<int, std::chrono::steady_clock::time_point>> keys(count);
+  std::vector<size_t> indegree(count);
+  std::vector<size_t> unread(count);
+  for (size_t i = 0; i < count; ++i) {
+    bytes[i] = static_cast<int64_t>(predictedBytes(tasks_[i].get()));
+    if (prioritized_) {
+      keys[i] = orderKey(tasks_[i].get());
+    }
+    indegree[i] = graph.inputs[i].size();
+    unread[i] = graph.readers[i].size();
+  }
+
+  struct Candidate {
+    std::pair<int, std::chrono::steady_clock::time_point> key;
+    int64_t growth;
+    uint64_t readied;
+    size_t task;
+    uint32_t version;
+  };
+  auto later = [](const Candidate& lhs, const Candidate& rhs) {
+    if (lhs.key.first != rhs.key.first) {
+      return lhs.key.first < rhs.key.first;
+    }
+    if (lhs.key.second != rhs.key.second) {
+      return lhs.key.second > rhs.key.second;
+    }
+    if (lhs.growth != rhs.growth) {
+      return lhs.growth > rhs.growth;
+    }
+    return lhs.readied < rhs.readied;
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>, decltype(later)> ready(later);
+  std::vector<uint32_t> version(count, 0);
+  std::vector<uint64_t> readied(count, 0);
+  std::vector<bool> placed(count, false);
+  uint64_t sequence = 0;
+
+  auto push = [&](size_t task) {
+    int64_t growth = graph.readers[task].empty() ? 0 : bytes[task];
+    for (size_t input : graph.inputs[task]) {
+      if (unread[input] == 1) {
+        growth -= bytes[input];
+      }
+    }
+    ready.push(Candidate{keys[task], growth, readied[task], task, ++version[task]});
+  };
+  for (size_t i = 0; i < count; ++i) {
+    if (indegree[i] == 0) {
+      readied[i] = sequence++;
+      push(i);
+    }
+  }
+
+  std::vector<std::shared_ptr<TaskBase>> vec;
+  vec.reserve(count);
+  while (!ready.empty()) {
+    Candidate current = ready.top();
+    ready.pop();
+    if (placed[current.task] || current.version != version[current.task]) {
+      continue;
+    }
+    placed[current.task] = true;
+    vec.push_back(tasks_[current.task]);
+
+    for (size_t input : graph.inputs[current.task]) {
+      if (--unread[input] != 1) {
+        continue;
+      }
+      // The one reader left now frees this input; refresh it if it is ready.
+      for (size_t reader : graph.readers[input]) {
+        if (!placed[reader] && indegree[reader] == 0) {
+          push(reader);
+        }
+      }
+    }
+    for (size_t reader : graph.readers[current.task]) {
+      if (--indegree[reader] == 0) {
+        readied[reader] = sequence++;
+        push(reader);
+      }
+    }
+  }
+
   tasks_ = std::move(vec);
 }
 
+PeakMemory TTaskScheduler::peakMemory() {
+  PeakMemory peak;
+  peak.actual = live_peak_;
+  if (pool_) {
+    return peak;
+  }
+  ensureOrder();
+
+  std::vector<std::shared_ptr<TaskBase>> order;
+  order.reserve(table_.size());
+  for (const TaskSlot& slot : table_) {
+    order.push_back(slot.task->shared_from_this());
+  }
+  PositionGraph graph = PositionGraph::Of(order);
+  std::vector<size_t> unread(order.size());
+  std::vector<size_t> bytes(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    unread[i] = graph.readers[i].size();
+    bytes[i] = predictedBytes(order[i].get());
+  }
+
+  size_t live = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    live += bytes[i];
+    peak.predicted = std::max(peak.predicted, live);
+    for (size_t input : graph.inputs[i]) {
+      if (--unread[input] == 0) {
+        live -= bytes[input];
+      }
+    }
+    if (unread[i] == 0) {
+      live -= bytes[i];
+    }
+  }
+  return peak;
+}
+
 void TTaskScheduler::DFS(
     std::vector<std::shared_ptr<TaskBase>>& vec, 
     std::shared_ptr<TaskBase> start,
@@ -50,11 +839,762 @@ void TTaskScheduler::DFS(
   
   current_state = VISITING;
   
-  for (auto& dep : start->GetDependecies()) {
-    DFS(vec, dep, state);
+  uint32_t id = reduced_ && !has_foreign_ ? findTask(start.get()) : kNoTask;
+  if (id != kNoTask) {
+    for (uint32_t dep : states_[id].dependencies) {
+      DFS(vec, by_id_[dep]->shared_from_this(), state);
+    }
+  } else {
+    for (auto& dep : start->GetDependecies()) {
+      DFS(vec, dep, state);
+    }
   }
   
   current_state = VISITED;
   
   vec.push_back(start);
-}
\ No newline at end of file
+}
+
+void TTaskScheduler::registerTask(std::shared_ptr<TaskBase> task) {
+  if (next_options_.priority < 0 || next_options_.priority >= ThreadPool::kPriorityLevels) {
+    throw std::invalid_argument("Task priority must be in [0, " +
+                                std::to_string(ThreadPool::kPriorityLevels) + ")");
+  }
+  if (pool_) {
+    validateResources(next_options_);
+    // Nothing would hold the reader back until a foreign producer finished.
+    for (auto& dep : task->GetDependecies()) {
+      if (findTask(dep.get()) == kNoTask) {
+        throw std::invalid_argument("An eager scheduler reads only results of its own tasks");
+      }
+    }
+  } else if (next_options_.executor) {
+    throw std::logic_error("Executors require an eager scheduler");
+  }
+  tasks_.push_back(task);
+
+  TaskBase* raw = task.get();
+  uint32_t id;
+  std::vector<ReadyTask> ready;
+  std::exception_ptr upstream_error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = status_.Append();
+    raw->id_ = id;
+    raw->bindStatus(&status_[id], &edge_epoch_);
+    by_id_.push_back(raw);
+    ord_.push_back(kNoTask);
+    pending_.push_back(0);
+    priority_.push_back(next_options_.priority);
+    states_.emplace_back();
+
+    TaskState& state = states_[id];
+    state.options = next_options_;
+    state.deadline = next_options_.deadline;
+    if (priority_[id] != 0 || state.deadline != std::chrono::steady_clock::time_point::max()) {
+      prioritized_ = true;
+      inheritPriority(id);
+    }
+
+    if (!pool_) {
+      // The new task's own edges were counted before it was bound.
+      bool in_order = order_valid_ && !prioritized_ && !minimize_peak_memory_ &&
+                      order_epoch_ == edge_epoch_.load(std::memory_order_relaxed);
+      for (auto& dep : raw->dependencies_) {
+        uint32_t dep_id = findTask(dep.get());
+        if (dep_id == kNoTask) {
+          has_foreign_ = true;
+          in_order = false;
+          continue;
+        }
+        state.dependencies.push_back(dep_id);
+        states_[dep_id].dependents.push_back(id);
+        addDataEdge(dep_id, id);
+      }
+      if (spill_file_) {
+        raw->spill_owner_ = this;
+      }
+
+      if (in_order) {
+        ord_[id] = static_cast<uint32_t>(table_.size());
+        table_.push_back(slotOf(id));
+      } else {
+        order_valid_ = false;
+      }
+      return;
+    }
+    order_valid_ = false;
+    ++outstanding_;
+
+    for (auto& dep : raw->dependencies_) {
+      uint32_t dep_id = findTask(dep.get());
+      state.dependencies.push_back(dep_id);
+      states_[dep_id].dependents.push_back(id);
+      if (hasStatus(dep_id, TASK_FINISHED)) {
+        if (states_[dep_id].error) {
+          state.error = states_[dep_id].error;
+        }
+        continue;
+      }
+      ++pending_[id];
+    }
+
+    state.timer = next_timer_;
+    state.interval = next_interval_;
+    if (state.timer != NO_TIMER) {
+      if (state.timer == DELAYED_TIMER) {
+        ++pending_[id];
+      }
+      timed_.push_back(id);
+      armTimer(id, std::chrono::steady_clock::now() + state.interval);
+    }
+
+    if (pending_[id] != 0) {
+      return;
+    }
+    upstream_error = state.error;
+    if (!upstream_error) {
+      makeReady(id, ready);
+    }
+  }
+
+  if (upstream_error) {
+    finishTask(id, upstream_error);
+  }
+  for (const ReadyTask& next : ready) {
+    dispatch(next);
+  }
+}
+
+SchedulerStats TTaskScheduler::stats() {
+  SchedulerStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.tasks_added = by_id_.size();
+  }
+  stats_.ForEach([&stats](const StatsShard& shard) { shard.AddTo(stats); });
+  if (pool_) {
+    stats.ready_queue_depth = pool_->Pending();
+    stats.workers = pool_->WorkerStatistics();
+  }
+  stats.results_spilled = results_spilled_;
+  stats.results_restored = results_restored_;
+  stats.bytes_spilled = bytes_spilled_;
+  return stats;
+}
+
+std::vector<StragglerReport> TTaskScheduler::stragglers() {
+  if (!watchdog_) {
+    return {};
+  }
+  return watchdog_->Reports();
+}
+
+void TTaskScheduler::checkStragglers() {
+  std::vector<Watchdog::Candidate> candidates = watchdog_->Scan(StatsNow());
+  std::vector<StragglerReport> reports;
+  if (!candidates.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& candidate : candidates) {
+      reports.push_back(describeStraggler(candidate));
+    }
+  }
+  for (auto& report : reports) {
+    watchdog_->Report(std::move(report));
+  }
+
+  timers_->Schedule(std::chrono::steady_clock::now() + watchdog_->Interval(),
+                    [this] { checkStragglers(); });
+}
+
+StragglerReport TTaskScheduler::describeStraggler(const Watchdog::Candidate& candidate) const {
+  StragglerReport report;
+  report.task_id = candidate.task_id;
+  report.elapsed = std::chrono::nanoseconds(candidate.elapsed);
+  report.limit = std::chrono::nanoseconds(candidate.limit);
+
+  uint8_t done = pool_ ? static_cast<uint8_t>(TASK_FINISHED) : TaskBase::kExecuted;
+  std::vector<uint32_t> depth(by_id_.size(), kNoTask);
+  std::vector<uint32_t> stack{candidate.task_id};
+  while (!stack.empty()) {
+    uint32_t current = stack.back();
+    if (depth[current] != kNoTask) {
+      stack.pop_back();
+      continue;
+    }
+    uint32_t longest = 0;
+    bool known = true;
+    for (uint32_t dep : states_[current].dependencies) {
+      if (depth[dep] == kNoTask) {
+        known = false;
+        stack.push_back(dep);
+      } else {
+        longest = std::max(longest, depth[dep] + 1);
+      }
+    }
+    if (known) {
+      depth[current] = longest;
+      stack.pop_back();
+    }
+  }
+  report.depth = depth[candidate.task_id];
+
+  std::vector<bool> seen(by_id_.size(), false);
+  stack.assign(1, candidate.task_id);
+  while (!stack.empty()) {
+    uint32_t current = stack.back();
+    stack.pop_back();
+    for (uint32_t dependent : states_[current].dependents) {
+      if (seen[dependent] || hasStatus(dependent, done)) {
+        continue;
+      }
+      seen[dependent] = true;
+      ++report.blocked;
+      if (current == candidate.task_id) {
+        report.waiting.push_back(dependent);
+      }
+      stack.push_back(dependent);
+    }
+  }
+  return report;
+}
+
+uint32_t TTaskScheduler::nextGeneration() {
+  static std::atomic<uint32_t> generation{0};
+  return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+TaskBase* TTaskScheduler::resolveTask(uint32_t index, uint32_t generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation != generation_ || index >= by_id_.size()) {
+    throw std::out_of_range("Task reference does not belong to this scheduler");
+  }
+  return by_id_[index];
+}
+
+uint32_t TTaskScheduler::findTask(const TaskBase* task) const {
+  uint32_t id = task->id_;
+  if (id < by_id_.size() && by_id_[id] == task) {
+    return id;
+  }
+  return kNoTask;
+}
+
+void TTaskScheduler::dispatch(const ReadyTask& ready) {
+  TaskBase* task = ready.task;
+  ready.executor->Submit([this, task] { runTask(task); }, ready.options);
+}
+
+void TTaskScheduler::runTask(TaskBase* task) {
+  while (task) {
+    task = runOne(task);
+  }
+}
+
+TaskBase* TTaskScheduler::runOne(TaskBase* task) {
+  StatsShard* shard = localStats();
+  int64_t started = 0;
+  bool sampled = shard && shard->Sample();
+  if (sampled) {
+    shard->RecordQueueDepth(pool_->Pending());
+  }
+  bool costed = inline_below_ns_ > 0 && RunCosts::Sample();
+  if (sampled || costed) {
+    started = StatsNow();
+  }
+  bool may_inline = inline_continuations_ || inline_below_ns_ > 0;
+
+  std::exception_ptr error;
+  {
+    Watchdog::Scope watch(watchdog_.get(), task->id_, task->run_);
+    try {
+      task->run_(task);
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+
+  int64_t ran = started != 0 ? StatsNow() : 0;
+  if (costed) {
+    RunCosts::Global().Record(task->run_, ran - started);
+  }
+  if (!shard) {
+    return finishTask(task->id_, error, nullptr, 0, may_inline);
+  }
+  shard->RecordRun(error != nullptr);
+  if (!sampled) {
+    return finishTask(task->id_, error, nullptr, 0, may_inline);
+  }
+  shard->RecordSample(ran - started);
+  return finishTask(task->id_, error, shard, ran, may_inline);
+}
+
+TaskBase* TTaskScheduler::finishTask(uint32_t id, std::exception_ptr error, StatsShard* shard,
+                                     int64_t since, bool may_inline) {
+  std::vector<ReadyTask> ready;
+  bool worker = false;
+  bool foreign = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<uint32_t, std::exception_ptr>> finished{{id, error}};
+    bool released = false;
+
+    while (!finished.empty()) {
+      auto [current, current_error] = finished.back();
+      finished.pop_back();
+
+      TaskState& state = states_[current];
+      TaskBase::notifyStatus(status_[current],
+                             status_[current].fetch_or(TASK_FINISHED, std::memory_order_release));
+      state.error = current_error;
+      --outstanding_;
+
+      if (hasStatus(current, TASK_HOLDS_RESOURCES)) {
+        releaseResources(current);
+        released = true;
+      }
+
+      if (current_error && !error_ && current_error != cancelled_) {
+        error_ = current_error;
+      }
+
+      for (uint32_t dependent : state.dependents) {
+        TaskState& dependent_state = states_[dependent];
+        if (current_error && !dependent_state.error) {
+          dependent_state.error = current_error;
+        }
+        if (--pending_[dependent] != 0) {
+          continue;
+        }
+        if (dependent_state.error) {
+          finished.emplace_back(dependent, dependent_state.error);
+        } else {
+          makeReady(dependent, ready);
+        }
+      }
+    }
+
+    if (released) {
+      retryBlocked(ready);
+    }
+
+    if (outstanding_ == 0 && drained_callback_) {
+      Function<void(std::exception_ptr)> callback = std::move(drained_callback_);
+      callback(error_);
+    }
+    // Recorded under the lock: once it drops, the scheduler may be destroyed.
+    if (shard) {
+      shard->RecordOverheadSample(StatsNow() - since);
+    }
+    // A dispatched task may drain the graph before the loop below is done.
+    // Pool workers are joined before the pool goes away; any other thread
+    // holds the destructor off until it stops touching the scheduler.
+    worker = !ready.empty() && pool_ && pool_->IsWorkerThread();
+    foreign = !ready.empty() && pool_ && !worker;
+    if (foreign) {
+      ++dispatching_;
+    }
+    finished_cv_.notify_all();
+  }
+
+  size_t kept = may_inline && worker ? inlineCandidate(ready) : ready.size();
+  for (size_t i = 0; i < ready.size(); ++i) {
+    if (i != kept) {
+      dispatch(ready[i]);
+    }
+  }
+  if (foreign) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --dispatching_;
+    finished_cv_.notify_all();
+  }
+  return kept < ready.size() ? ready[kept].task : nullptr;
+}
+
+size_t TTaskScheduler::inlineCandidate(const std::vector<ReadyTask>& ready) const {
+  for (size_t i = 0; i < ready.size(); ++i) {
+    const ReadyTask& candidate = ready[i];
+    if (candidate.executor != executor_.get()) {
+      continue;
+    }
+    if (ready.size() == 1 && inline_continuations_) {
+      return i;
+    }
+    if (inline_below_ns_ > 0 &&
+        RunCosts::Global().MeanNanoseconds(candidate.task->Runner()) < inline_below_ns_) {
+      return i;
+    }
+  }
+  return ready.size();
+}
+
+void TTaskScheduler::inheritPriority(uint32_t id) {
+  int priority = priority_[id];
+  auto deadline = states_[id].deadline;
+
+  std::vector<uint32_t> stack{id};
+  while (!stack.empty()) {
+    uint32_t current = stack.back();
+    stack.pop_back();
+
+    for (auto& dep : by_id_[current]->dependencies_) {
+      uint32_t dep_id = findTask(dep.get());
+      if (dep_id == kNoTask || hasStatus(dep_id, TASK_FINISHED)) {
+        continue;
+      }
+      TaskState& dep_state = states_[dep_id];
+      if (priority_[dep_id] >= priority && dep_state.deadline <= deadline) {
+        continue;
+      }
+      priority_[dep_id] = std::max(priority_[dep_id], priority);
+      dep_state.deadline = std::min(dep_state.deadline, deadline);
+      stack.push_back(dep_id);
+    }
+  }
+}
+
+void TTaskScheduler::makeReady(uint32_t id,
+                               std::vector<ReadyTask>& ready) {
+  if (!tryAcquireResources(id)) {
+    blocked_.push_back(id);
+    return;
+  }
+  ready.push_back(readyTask(id));
+}
+
+TTaskScheduler::ReadyTask TTaskScheduler::readyTask(uint32_t id) const {
+  const TaskState& state = states_[id];
+  Executor* executor = state.options.executor ? state.options.executor.get() : executor_.get();
+  return ReadyTask{by_id_[id],
+                   JobOptions{.node = state.options.node,
+                              .priority = priority_[id],
+                              .deadline = state.deadline},
+                   executor};
+}
+
+void TTaskScheduler::retryBlocked(std::vector<ReadyTask>& ready) {
+  std::stable_sort(blocked_.begin(), blocked_.end(), [this](uint32_t lhs, uint32_t rhs) {
+    return priority_[lhs] > priority_[rhs];
+  });
+
+  size_t kept = 0;
+  for (size_t i = 0; i < blocked_.size(); ++i) {
+    uint32_t id = blocked_[i];
+    if (tryAcquireResources(id)) {
+      ready.push_back(readyTask(id));
+    } else {
+      blocked_[kept++] = id;
+    }
+  }
+  blocked_.resize(kept);
+}
+
+void TTaskScheduler::validateResources(const TaskOptions& options) const {
+  if (memory_budget_ != 0 && options.memory > memory_budget_) {
+    throw std::invalid_argument("Task memory exceeds the scheduler memory budget");
+  }
+  for (const auto& request : options.resources) {
+    auto it = resource_limits_.find(request.name);
+    if (it != resource_limits_.end() && request.amount > it->second) {
+      throw std::invalid_argument("Task requests more of '" + request.name +
+                                  "' than the scheduler limit");
+    }
+  }
+}
+
+bool TTaskScheduler::tryAcquireResources(uint32_t id) {
+  const TaskOptions& options = states_[id].options;
+  if (options.memory == 0 && options.resources.empty()) {
+    return true;
+  }
+
+  if (memory_budget_ != 0 && memory_in_use_ + options.memory > memory_budget_) {
+    return false;
+  }
+  for (const auto& request : options.resources) {
+    auto it = resource_limits_.find(request.name);
+    if (it != resource_limits_.end() &&
+        resources_in_use_[request.name] + request.amount > it->second) {
+      return false;
+    }
+  }
+
+  memory_in_use_ += options.memory;
+  for (const auto& request : options.resources) {
+    resources_in_use_[request.name] += request.amount;
+  }
+  setStatus(id, TASK_HOLDS_RESOURCES);
+  return true;
+}
+
+void TTaskScheduler::releaseResources(uint32_t id) {
+  const TaskOptions& options = states_[id].options;
+  memory_in_use_ -= options.memory;
+  for (const auto& request : options.resources) {
+    resources_in_use_[request.name] -= request.amount;
+  }
+  clearStatus(id, TASK_HOLDS_RESOURCES);
+}
+
+void TTaskScheduler::wait(const std::shared_ptr<TaskBase>& task, bool help) {
+  if (pool_) {
+    waitForTask(task.get(), help);
+  } else {
+    task->Execute();
+  }
+}
+
+void TTaskScheduler::waitForTask(TaskBase* task, bool help) {
+  uint32_t id;
+  std::atomic<uint8_t>* status;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = findTask(task);
+    if (id == kNoTask) {
+      return;
+    }
+    status = &status_[id];
+  }
+
+  // A pool thread parks only once there is nothing left to help with, and a
+  // spare serves the queues until the task it waits on finishes.
+  bool worker = pool_->IsWorkerThread();
+  uint8_t current = status->load(std::memory_order_acquire);
+  while ((current & TASK_FINISHED) == 0) {
+    if ((help || worker) && pool_->RunOne()) {
+      current = status->load(std::memory_order_acquire);
+      continue;
+    }
+    {
+      ThreadPool::Blocking blocking;
+      TaskBase::waitStatus(*status, current);
+    }
+    current = status->load(std::memory_order_acquire);
+  }
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error = states_[id].error;
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// Children run where their parent does, at its current priority and deadline.
+SpawnTarget TTaskScheduler::spawnTarget(TaskBase* task) {
+  if (!pool_) {
+    return SpawnTarget{};
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReadyTask ready = readyTask(task->id_);
+  return SpawnTarget{pool_.get(), ready.executor, ready.options};
+}
+
+void TTaskScheduler::waitForAll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_cv_.wait(lock, [this] { return outstanding_ == 0; });
+
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void TTaskScheduler::notifyWhenDrained(Function<void(std::exception_ptr)> callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (outstanding_ == 0) {
+    callback(error_);
+    return;
+  }
+  drained_callback_ = std::move(callback);
+}
+
+void TTaskScheduler::requireWorkers() const {
+  if (!pool_) {
+    throw std::logic_error("Stream and timer tasks require an eager scheduler");
+  }
+}
+
+std::shared_ptr<Task<Buffer>> TTaskScheduler::addRead(std::string path) {
+  auto transfer = std::make_shared<FileTransfer>(std::move(path), fileIo());
+  auto task = std::make_shared<Task<Buffer>>([transfer] { return transfer->TakeBuffer(); });
+  registerTransfer(task, std::move(transfer));
+  return task;
+}
+
+std::shared_ptr<Task<size_t>> TTaskScheduler::addWrite(std::string path,
+                                                       const FutureResult<Buffer>& data) {
+  auto transfer = std::make_shared<FileTransfer>(std::move(path), &data.get(), fileIo());
+  auto task = std::make_shared<Task<size_t>>(
+      [transfer](const Buffer&) { return transfer->Written(); }, data);
+  task->AddDependendTask(data.getTask());
+  registerTransfer(task, std::move(transfer));
+  return task;
+}
+
+std::shared_ptr<Task<size_t>> TTaskScheduler::addWrite(std::string path, Buffer data) {
+  auto source = std::make_shared<Buffer>(std::move(data));
+  auto transfer = std::make_shared<FileTransfer>(std::move(path), source.get(), fileIo());
+  auto task = std::make_shared<Task<size_t>>([transfer, source] { return transfer->Written(); });
+  registerTransfer(task, std::move(transfer));
+  return task;
+}
+
+// The transfer becomes the task's executor, so dispatching the task starts
+// the I/O and its completion runs the task.
+void TTaskScheduler::registerTransfer(std::shared_ptr<TaskBase> task,
+                                      std::shared_ptr<FileTransfer> transfer) {
+  if (!pool_) {
+    registerTask(std::move(task));
+    return;
+  }
+  std::shared_ptr<Executor> executor = std::move(next_options_.executor);
+  next_options_.executor = std::move(transfer);
+  try {
+    registerTask(std::move(task));
+  } catch (...) {
+    next_options_.executor = std::move(executor);
+    throw;
+  }
+  next_options_.executor = std::move(executor);
+}
+
+std::shared_ptr<FileIo> TTaskScheduler::fileIo() {
+  if (!pool_) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_io_) {
+    file_io_ = std::make_shared<FileIo>();
+  }
+  return file_io_;
+}
+
+bool TTaskScheduler::cancel(const std::shared_ptr<TaskBase>& task) {
+  uint32_t id;
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = findTask(task.get());
+    if (id == kNoTask || !hasStatus(id, TASK_TIMER_ARMED)) {
+      return false;
+    }
+    if (dropTimer(id)) {
+      error = states_[id].error;
+    }
+  }
+
+  if (error) {
+    finishTask(id, error);
+  }
+  return true;
+}
+
+void TTaskScheduler::armTimer(uint32_t id, std::chrono::steady_clock::time_point due) {
+  if (!timers_) {
+    timers_ = std::make_unique<TimerService>();
+  }
+
+  TaskState& state = states_[id];
+  uint64_t generation = state.timer_generation;
+  state.due = due;
+  setStatus(id, TASK_TIMER_ARMED);
+  state.timer_id = timers_->Schedule(due, [this, id, generation] {
+    onTimer(id, generation);
+  });
+}
+
+void TTaskScheduler::onTimer(uint32_t id, uint64_t generation) {
+  std::vector<ReadyTask> ready;
+  std::exception_ptr upstream_error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TaskState& state = states_[id];
+    if (!hasStatus(id, TASK_TIMER_ARMED) || state.timer_generation != generation) {
+      return;
+    }
+    clearStatus(id, TASK_TIMER_ARMED);
+
+    if (state.timer == DELAYED_TIMER) {
+      if (--pending_[id] != 0) {
+        return;
+      }
+      upstream_error = state.error;
+      if (!upstream_error) {
+        makeReady(id, ready);
+      }
+    } else {
+      auto now = std::chrono::steady_clock::now();
+      auto due = state.due + state.interval;
+      while (due <= now) {
+        due += state.interval;
+      }
+      armTimer(id, due);
+
+      if (restartPeriodic(id)) {
+        makeReady(id, ready);
+      }
+    }
+  }
+
+  if (upstream_error) {
+    finishTask(id, upstream_error);
+  }
+  for (const ReadyTask& next : ready) {
+    dispatch(next);
+  }
+}
+
+bool TTaskScheduler::restartPeriodic(uint32_t id) {
+  std::vector<uint32_t> closure{id};
+  std::vector<bool> in_closure(by_id_.size(), false);
+  in_closure[id] = true;
+  for (size_t i = 0; i < closure.size(); ++i) {
+    if (!hasStatus(closure[i], TASK_FINISHED)) {
+      return false;
+    }
+    for (uint32_t dependent : states_[closure[i]].dependents) {
+      if (!in_closure[dependent]) {
+        in_closure[dependent] = true;
+        closure.push_back(dependent);
+      }
+    }
+  }
+
+  for (uint32_t current : closure) {
+    clearStatus(current, TASK_FINISHED);
+    states_[current].error = nullptr;
+    pending_[current] = 0;
+    by_id_[current]->Reset();
+    for (uint32_t dep_id : states_[current].dependencies) {
+      if (in_closure[dep_id]) {
+        ++pending_[current];
+      }
+    }
+  }
+  outstanding_ += closure.size();
+
+  return pending_[id] == 0;
+}
+
+bool TTaskScheduler::dropTimer(uint32_t id) {
+  if (!hasStatus(id, TASK_TIMER_ARMED)) {
+    return false;
+  }
+  TaskState& state = states_[id];
+  clearStatus(id, TASK_TIMER_ARMED);
+  ++state.timer_generation;
+  timers_->Cancel(state.timer_id);
+
+  if (state.timer != DELAYED_TIMER) {
+    return false;
+  }
+  if (!cancelled_) {
+    cancelled_ = std::make_exception_ptr(TaskCancelled());
+  }
+  if (!state.error) {
+    state.error = cancelled_;
+  }
+  return --pending_[id] == 0;
+}
@@ -1,10 +1,30 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "channel.h"
+#include "executor.h"
+#include "file_io.h"
+#include "runtime.h"
+#include "stats.h"
+#include "status_table.h"
 #include "task.h"
+#include "task_context.h"
+#include "thread_pool.h"
+#include "thread_shards.h"
+#include "timing_wheel.h"
+#include "watchdog.h"
 
 enum VISIT {
   NOT_VISITED,
@@ -16,41 +36,208 @@ template <typename T> struct is_future_result : std::false_type {};
 template <typename T>
 struct is_future_result<FutureResult<T>> : std::true_type {};
 
+template <typename T> struct is_stream_result : std::false_type {};
+template <typename T>
+struct is_stream_result<StreamResult<T>> : std::true_type {};
+
+// Eager only: trades idle CPU for lower latency on small graphs.
+struct LatencyOptions {
+  // Idle workers of the scheduler's own pool poll this long before parking.
+  // A shared pool takes ThreadPoolOptions::spin instead.
+  std::chrono::nanoseconds spin{0};
+  // A worker whose task readies exactly one dependent runs it next itself
+  // instead of passing it through the queue.
+  bool inline_continuations = false;
+  // A worker also keeps one newly-ready task whose callable has a measured
+  // mean run time below this, queueing the rest; zero disables. Run times
+  // are sampled per callable, so a callable is queued until it was timed.
+  std::chrono::nanoseconds inline_below{0};
+
+  bool Enabled() const {
+    return spin.count() > 0 || inline_continuations || inline_below.count() > 0;
+  }
+
+  // Settings for graphs of a few dozen small tasks that must finish fast.
+  static LatencyOptions Low() {
+    return LatencyOptions{.spin = std::chrono::microseconds(50),
+                          .inline_continuations = true,
+                          .inline_below = std::chrono::microseconds(2)};
+  }
+};
+
+struct SchedulerOptions {
+  // Dispatch tasks to workers as soon as their inputs are ready. add() then
+  // throws std::invalid_argument for a FutureResult of a task it does not own.
+  bool eager = false;
+  size_t workers = 0;
+  bool pin_workers = false;
+  std::shared_ptr<ThreadPool> pool;
+  // Runs the scheduler on a shared Runtime, which implies eager; see Tenant.
+  std::shared_ptr<Tenant> tenant;
+  size_t memory_budget = 0;
+  std::unordered_map<std::string, size_t> resource_limits;
+  WatchdogOptions watchdog;
+  // Serves addRead and addWrite; created on first use when unset.
+  std::shared_ptr<FileIo> file_io;
+  // Serial only: once finished results with a ResultSerializer take more than
+  // this many bytes, the ones needed furthest ahead in the execution order
+  // are spilled to an unlinked file in spill_directory (the system temporary
+  // directory when empty) and mapped back in before their next reader.
+  size_t result_budget = 0;
+  std::string spill_directory;
+  // Serial only: order tasks to keep the peak size of live results low
+  // instead of depth-first from insertion order. Priorities still come first.
+  bool minimize_peak_memory = false;
+  LatencyOptions latency;
+};
+
+struct ResourceRequest {
+  std::string name;
+  size_t amount = 1;
+};
+
+struct TaskOptions {
+  int node = -1;
+  size_t memory = 0;
+  std::vector<ResourceRequest> resources;
+  // Higher runs first, from 0 to ThreadPool::kPriorityLevels - 1, one pool
+  // queue level each; add() throws std::invalid_argument outside that range.
+  int priority = 0;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  // Where the task runs; the scheduler's CPU pool when unset. Eager only.
+  std::shared_ptr<Executor> executor;
+  // Expected size of the result for memory-aware ordering; when zero the
+  // task's last measured footprint is used.
+  size_t result_bytes = 0;
+};
 
-class TTaskScheduler {
+// Peak bytes held by live results: finished results that a pending task
+// still reads, plus the result being produced.
+struct PeakMemory {
+  // From the size estimates, for the current serial order.
+  size_t predicted = 0;
+  // Measured over the last serial run; only with minimize_peak_memory.
+  size_t actual = 0;
+};
+
+struct GraphReduction {
+  size_t duplicate_edges = 0;
+  size_t transitive_edges = 0;
+
+  size_t Removed() const { return duplicate_edges + transitive_edges; }
+};
 
+class TaskCancelled : public std::runtime_error {
 public:
-  template <typename Callable, typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>> 
+  TaskCancelled() : std::runtime_error("Task cancelled") {}
+};
+
+template <typename Input, typename Output> class TPipeline;
+
+class TTaskScheduler : private SpillOwner {
+
+public:
+  TTaskScheduler() = default;
+
+  explicit TTaskScheduler(SchedulerOptions options);
+
+  TTaskScheduler(const TTaskScheduler&) = delete;
+  TTaskScheduler& operator=(const TTaskScheduler&) = delete;
+
+  ~TTaskScheduler();
+
+  class TaskBuilder {
+  public:
+    TaskBuilder(TTaskScheduler& scheduler, TaskOptions options)
+        : scheduler_(scheduler), options_(options) {}
+
+    template <typename... Args>
+    auto add(Args&&... args) {
+      scheduler_.next_options_ = options_;
+      try {
+        auto task = scheduler_.add(std::forward<Args>(args)...);
+        scheduler_.next_options_ = TaskOptions{};
+        return task;
+      } catch (...) {
+        scheduler_.next_options_ = TaskOptions{};
+        throw;
+      }
+    }
+
+  private:
+    TTaskScheduler& scheduler_;
+    TaskOptions options_;
+  };
+
+  TaskBuilder with(TaskOptions options) {
+    return TaskBuilder(*this, options);
+  }
+
+  TaskBuilder on(std::shared_ptr<Executor> executor) {
+    TaskOptions options;
+    options.executor = std::move(executor);
+    return TaskBuilder(*this, options);
+  }
+
+  template <typename Callable, typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value &&
+                                                          std::is_invocable_v<Callable&>>>
   auto add(Callable&& callable) {
     using ReturnType = decltype(callable());
     auto task =
         std::make_shared<Task<ReturnType>>(std::forward<Callable>(callable));
-    tasks_.push_back(task);
+    registerTask(task);
+    return task;
+  }
+
+  // A callable taking a TaskContext& can spawn and join children while it
+  // runs; the task finishes once they all have. See TaskContext.
+  template <typename Callable,
+            typename = std::enable_if_t<!std::is_invocable_v<Callable&> &&
+                                        std::is_invocable_v<std::decay_t<Callable>&, TaskContext&>>,
+            typename = void>
+  auto add(Callable&& callable) {
+    using ReturnType = std::invoke_result_t<std::decay_t<Callable>&, TaskContext&>;
+    auto self = std::make_shared<TaskBase*>(nullptr);
+    auto task = std::make_shared<Task<ReturnType>>(
+        [this, self, callable = std::forward<Callable>(callable)]() -> ReturnType {
+          TaskContext context(spawnTarget(*self));
+          if constexpr (std::is_void_v<ReturnType>) {
+            callable(context);
+            context.sync();
+          } else {
+            ReturnType result = callable(context);
+            context.sync();
+            return result;
+          }
+        });
+    *self = task.get();
+    registerTask(task);
     return task;
   }
 
   template <
       typename Callable, typename Arg1,
       typename = std::enable_if_t<!is_future_result<std::decay_t<Arg1>>::value &&
+                                  !is_stream_result<std::decay_t<Arg1>>::value &&
                                   !is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable&& callable, Arg1&& arg1) {
-    using ReturnType = decltype(callable(std::declval<std::decay_t<Arg1>>()));
+    using ReturnType = task_result_t<Callable, std::decay_t<Arg1>>;
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), std::forward<Arg1>(arg1));
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
   template <typename Callable, typename T,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable&& callable, const FutureResult<T>& future) {
-    using ReturnType = decltype(callable(std::declval<T>()));
+    using ReturnType = task_result_t<Callable, const T&>;
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), future);
 
     task->AddDependendTask(future.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -60,14 +247,13 @@ public:
                                  !is_future_result<std::decay_t<Arg2>>::value &&
                                  !is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable&& callable, Arg1&& arg1, Arg2&& arg2) {
-    using ReturnType = decltype(callable(std::declval<std::decay_t<Arg1>>(),
-                                         std::declval<std::decay_t<Arg2>>()));
+    using ReturnType = task_result_t<Callable, std::decay_t<Arg1>, std::decay_t<Arg2>>;
 
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), std::forward<Arg1>(arg1),
         std::forward<Arg2>(arg2));
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -76,15 +262,14 @@ public:
       typename = std::enable_if_t<!is_future_result<std::decay_t<Arg2>>::value &&
                                   !is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable &&callable, const FutureResult<T>& future, Arg2&& arg2) {
-    using ReturnType = decltype(callable(std::declval<T>(),
-                                         std::declval<std::decay_t<Arg2>>()));
+    using ReturnType = task_result_t<Callable, const T&, std::decay_t<Arg2>>;
 
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), future, std::forward<Arg2>(arg2));
 
     task->AddDependendTask(future.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -93,15 +278,14 @@ public:
       typename = std::enable_if_t<!is_future_result<std::decay_t<Arg1>>::value &&
                                   !is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable&& callable, Arg1&& arg1, const FutureResult<T>& future) {
-    using ReturnType = decltype(callable(std::declval<std::decay_t<Arg1>>(),
-                                         std::declval<T>()));
+    using ReturnType = task_result_t<Callable, std::decay_t<Arg1>, const T&>;
 
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), std::forward<Arg1>(arg1), future);
 
     task->AddDependendTask(future.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -109,8 +293,7 @@ public:
             typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   auto add(Callable&& callable, const FutureResult<T1>& future1,
            const FutureResult<T2>& future2) {
-    using ReturnType =
-        decltype(callable(std::declval<T1>(), std::declval<T2>()));
+    using ReturnType = task_result_t<Callable, const T1&, const T2&>;
 
     auto task = std::make_shared<Task<ReturnType>>(
         std::forward<Callable>(callable), future1, future2);
@@ -118,21 +301,72 @@ public:
     task->AddDependendTask(future1.getTask());
     task->AddDependendTask(future2.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
+  template <typename Callable, typename T,
+  typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
+  auto add(Callable&& callable, const StreamResult<T>& stream) {
+    requireWorkers();
+    using ReturnType = decltype(callable(std::declval<Channel<T>&>()));
+    auto task = std::make_shared<Task<ReturnType>>(
+        std::forward<Callable>(callable), stream);
+
+    registerTask(task);
+    return task;
+  }
+
+  template <typename T, typename Callable>
+  StreamResult<T> addStream(Callable&& producer, size_t capacity = 1024) {
+    requireWorkers();
+    auto channel = std::make_shared<Channel<T>>(capacity);
+    auto task = std::make_shared<Task<void>>(
+        [producer = std::forward<Callable>(producer), channel]() {
+          try {
+            producer(*channel);
+          } catch (...) {
+            channel->Close(std::current_exception());
+            throw;
+          }
+          channel->Close();
+        });
+
+    registerTask(task);
+    return StreamResult<T>(channel, task);
+  }
+
+  template <typename T, typename Callable, typename U>
+  StreamResult<T> addStream(Callable&& transform, const StreamResult<U>& input,
+                            size_t capacity = 1024) {
+    requireWorkers();
+    auto channel = std::make_shared<Channel<T>>(capacity);
+    auto task = std::make_shared<Task<void>>(
+        [transform = std::forward<Callable>(transform), input, channel]() {
+          try {
+            transform(input.channel(), *channel);
+          } catch (...) {
+            channel->Close(std::current_exception());
+            throw;
+          }
+          channel->Close();
+        });
+
+    registerTask(task);
+    return StreamResult<T>(channel, task);
+  }
+
   template <typename ReturnType, typename ClassType>
   auto add(ReturnType (ClassType::*method)(), ClassType& instance) {
     auto task = std::make_shared<Task<ReturnType>>(method, instance);
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
   template <typename ReturnType, typename ClassType>
   auto add(ReturnType (ClassType::*method)() const, ClassType& instance) {
     auto task = std::make_shared<Task<ReturnType>>(method, instance);
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -142,7 +376,7 @@ public:
           const FutureResult<T>& future) {
     auto task = std::make_shared<Task<ReturnType>>(method, instance, future);
     task->AddDependendTask(future.getTask());
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -152,7 +386,7 @@ public:
           const FutureResult<T>& future) {
     auto task = std::make_shared<Task<ReturnType>>(method, instance, future);
     task->AddDependendTask(future.getTask());
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -164,7 +398,7 @@ public:
     auto task = std::make_shared<Task<ReturnType>>(method, instance,
                                                    std::forward<Arg>(arg));
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -176,7 +410,7 @@ public:
     auto task = std::make_shared<Task<ReturnType>>(method, instance,
                                                    std::forward<Arg>(arg));
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -187,7 +421,7 @@ public:
 
     task->AddDependendTask(future.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -198,7 +432,7 @@ public:
 
     task->AddDependendTask(future.getTask());
 
-    tasks_.push_back(task);
+    registerTask(task);
     return task;
   }
 
@@ -209,13 +443,283 @@ public:
 
   template <typename T> 
   const T& getResult(std::shared_ptr<Task<T>> task) {
+    if (pool_) {
+      waitForTask(task.get());
+    }
     return task->GetResult();
   }
 
+  // Blocks until `task` has finished; safe to call from any thread while the
+  // graph runs. With `help` the caller runs queued work while it waits, which
+  // pool workers always do. A serial scheduler runs the task on the caller
+  // unless another thread already is.
+  void wait(const std::shared_ptr<TaskBase>& task, bool help = false);
+
+  template <typename T>
+  TaskRef<T> getRef(const std::shared_ptr<Task<T>>& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id = findTask(task.get());
+    if (id == kNoTask) {
+      throw std::invalid_argument("Task does not belong to this scheduler");
+    }
+    return TaskRef<T>(id, generation_);
+  }
+
+  template <typename T>
+  FutureResult<T> getFutureResult(TaskRef<T> ref) {
+    return FutureResult<T>(resolve(ref));
+  }
+
+  template <typename T>
+  const T& getResult(TaskRef<T> ref) {
+    Task<T>* task = resolve(ref);
+    if (pool_) {
+      waitForTask(task);
+    }
+    return task->GetResult();
+  }
+
+  // Shared-ownership escape hatch for handles that must outlive the scheduler.
+  template <typename T>
+  std::shared_ptr<Task<T>> getTask(TaskRef<T> ref) {
+    return std::static_pointer_cast<Task<T>>(resolve(ref)->shared_from_this());
+  }
+
+  template <typename... Args>
+  auto addAfter(std::chrono::steady_clock::duration delay, Args&&... args) {
+    return addTimed(DELAYED_TIMER, delay, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  auto addPeriodic(std::chrono::steady_clock::duration interval, Args&&... args) {
+    return addTimed(PERIODIC_TIMER, interval, std::forward<Args>(args)...);
+  }
+
+  // Reads a whole file. An eager scheduler hands the read to the file I/O
+  // service and no worker blocks on it; a serial one reads in place.
+  std::shared_ptr<Task<Buffer>> addRead(std::string path);
+
+  // Writes the buffer to `path`, replacing its contents. The result is the
+  // number of bytes written.
+  std::shared_ptr<Task<size_t>> addWrite(std::string path, const FutureResult<Buffer>& data);
+  std::shared_ptr<Task<size_t>> addWrite(std::string path, Buffer data);
+
+  bool cancel(const std::shared_ptr<TaskBase>& task);
+
+  // Makes `task` run after `dependency`. Throws std::runtime_error and leaves
+  // the graph unchanged if the edge would close a cycle.
+  void addDependency(const std::shared_ptr<TaskBase>& task,
+                     const std::shared_ptr<TaskBase>& dependency);
+
   void executeAll();
 
+  bool executeAll(std::chrono::steady_clock::duration timeout);
+
+  void reset();
+
+  // Drops duplicate and transitively implied edges from the scheduler's own
+  // view of the graph. Task arguments are untouched. The reduced edges drive
+  // the serial order (unless a task reads a foreign result, when the full
+  // edges are walked), the incremental order, eager readiness counts and
+  // straggler reports. Spilling and peak-memory tracking keep reading every
+  // data edge, and MemorySort still plans on the full graph.
+  GraphReduction reduceGraph();
+
+  // Aggregates the per-thread counters. Cheap enough to poll, but not free:
+  // it takes the scheduler lock and walks every thread's histograms.
+  SchedulerStats stats();
+
+  PeakMemory peakMemory();
+
+  // Stragglers flagged by the watchdog so far, oldest first. Empty unless
+  // SchedulerOptions::watchdog is enabled.
+  std::vector<StragglerReport> stragglers();
+
 private:
+  enum TimerKind {
+    NO_TIMER,
+    DELAYED_TIMER,
+    PERIODIC_TIMER
+  };
+
+  // Scheduler-owned bits; bit 0 is TaskBase::kExecuted.
+  enum TaskStatus : uint8_t {
+    TASK_FINISHED = 2,
+    TASK_HOLDS_RESOURCES = 4,
+    TASK_TIMER_ARMED = 8
+  };
+
+  static constexpr uint32_t kNoTask = UINT32_MAX;
+
+  struct ReadyTask {
+    TaskBase* task;
+    JobOptions options;
+    Executor* executor;
+  };
+
+  struct TaskSlot {
+    TaskBase::RunFunction run;
+    TaskBase* task;
+    std::atomic<uint8_t>* status;
+  };
+
+  // Cold per-task data. The hot fields live in the dense arrays below.
+  struct TaskState {
+    TaskOptions options;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Scheduling edges, which reduceGraph may thin out.
+    std::vector<uint32_t> dependencies;
+    std::vector<uint32_t> dependents;
+    // Serial only: every local task read, and every reader, once each, as
+    // the edges were added. Spilling follows these, never the reduced ones.
+    std::vector<uint32_t> inputs;
+    std::vector<uint32_t> readers;
+    std::exception_ptr error;
+    TimerKind timer = NO_TIMER;
+    std::chrono::steady_clock::duration interval{};
+    std::chrono::steady_clock::time_point due;
+    TimerService::TimerId timer_id = 0;
+    uint64_t timer_generation = 0;
+  };
+
   std::vector<std::shared_ptr<TaskBase>> tasks_;
+  uint32_t generation_ = nextGeneration();
+  ThreadShards<StatsShard> stats_{generation_};
+  std::vector<TaskSlot> table_;
+  std::vector<uint32_t> ord_;
+  std::vector<uint8_t> marks_;
+  size_t run_from_ = 0;
+  bool order_valid_ = false;
+  // Edges added to registered tasks; order_epoch_ is its value at the last sort.
+  std::atomic<uint64_t> edge_epoch_{0};
+  uint64_t order_epoch_ = 0;
+  bool has_foreign_ = false;
+  // Set by reduceGraph; the order is then walked over states_ edges.
+  bool reduced_ = false;
+  TaskOptions next_options_;
+  TimerKind next_timer_ = NO_TIMER;
+  std::chrono::steady_clock::duration next_interval_{};
+
+  std::vector<TaskBase*> by_id_;
+  StatusTable status_;
+  std::vector<uint32_t> pending_;
+  std::vector<int> priority_;
+  std::vector<TaskState> states_;
+  std::vector<uint32_t> blocked_;
+  bool prioritized_ = false;
+  size_t memory_budget_ = 0;
+  size_t memory_in_use_ = 0;
+  std::unordered_map<std::string, size_t> resource_limits_;
+  std::unordered_map<std::string, size_t> resources_in_use_;
+  size_t outstanding_ = 0;
+  // finishTask calls still dispatching from threads the pool does not own.
+  size_t dispatching_ = 0;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable finished_cv_;
+  Function<void(std::exception_ptr)> drained_callback_;
+  std::shared_ptr<ThreadPool> pool_;
+  std::shared_ptr<Executor> executor_;
+  std::shared_ptr<FileIo> file_io_;
+  size_t result_budget_ = 0;
+  size_t resident_bytes_ = 0;
+  std::shared_ptr<SpillFile> spill_file_;
+  // Finished results that count against result_budget_, and their sizes.
+  std::vector<uint32_t> resident_;
+  std::vector<size_t> result_bytes_;
+  // The serial task running now; its inputs are never spilled under it.
+  uint32_t running_ = kNoTask;
+  uint64_t results_spilled_ = 0;
+  uint64_t results_restored_ = 0;
+  uint64_t bytes_spilled_ = 0;
+  bool minimize_peak_memory_ = false;
+  // Whether a worker may run a task it readied; see LatencyOptions.
+  bool inline_continuations_ = false;
+  int64_t inline_below_ns_ = 0;
+  // Live result bytes per task over the current run, their sum and its peak.
+  std::vector<size_t> live_bytes_;
+  size_t live_total_ = 0;
+  size_t live_peak_ = 0;
+  std::unique_ptr<TimerService> timers_;
+  std::unique_ptr<Watchdog> watchdog_;
+  std::vector<uint32_t> timed_;
+  std::exception_ptr cancelled_;
+
+  template <typename Input, typename Output> friend class TPipeline;
+
+  void registerTask(std::shared_ptr<TaskBase> task);
+  void registerTransfer(std::shared_ptr<TaskBase> task, std::shared_ptr<FileTransfer> transfer);
+  std::shared_ptr<FileIo> fileIo();
+  static uint32_t nextGeneration();
+  TaskBase* resolveTask(uint32_t index, uint32_t generation);
+  template <typename T>
+  Task<T>* resolve(TaskRef<T> ref) {
+    return static_cast<Task<T>*>(resolveTask(ref.index_, ref.generation_));
+  }
+  uint32_t findTask(const TaskBase* task) const;
+  bool hasStatus(uint32_t id, uint8_t bits) const {
+    return (status_[id].load(std::memory_order_relaxed) & bits) != 0;
+  }
+  void setStatus(uint32_t id, uint8_t bits) {
+    status_[id].fetch_or(bits, std::memory_order_release);
+  }
+  void clearStatus(uint32_t id, uint8_t bits) {
+    status_[id].fetch_and(static_cast<uint8_t>(~bits), std::memory_order_relaxed);
+  }
+  void dispatch(const ReadyTask& ready);
+  ReadyTask readyTask(uint32_t id) const;
+  void runTask(TaskBase* task);
+  TaskBase* runOne(TaskBase* task);
+  size_t inlineCandidate(const std::vector<ReadyTask>& ready) const;
+  void runSlot(const TaskSlot& slot, StatsShard* shard);
+  void addDataEdge(uint32_t from, uint32_t to);
+  void Restore(TaskBase* task) override;
+  void restoreResults(const std::vector<uint32_t>& ids);
+  void trackResult(uint32_t id);
+  void spillResults(const std::vector<uint32_t>& pinned);
+  void trackLiveness(uint32_t id);
+  size_t predictedBytes(TaskBase* task) const;
+  std::pair<int, std::chrono::steady_clock::time_point> orderKey(TaskBase* task) const;
+  StatsShard* localStats() { return kStatsEnabled ? &stats_.Local() : nullptr; }
+  // A sampling `shard` is charged the overhead from `since` to the unlock.
+  // With `may_inline`, one ready task may be returned for the caller to run
+  // instead of being dispatched.
+  TaskBase* finishTask(uint32_t id, std::exception_ptr error, StatsShard* shard = nullptr,
+                       int64_t since = 0, bool may_inline = false);
+  void inheritPriority(uint32_t id);
+  void makeReady(uint32_t id, std::vector<ReadyTask>& ready);
+  void retryBlocked(std::vector<ReadyTask>& ready);
+  void validateResources(const TaskOptions& options) const;
+  bool tryAcquireResources(uint32_t id);
+  void releaseResources(uint32_t id);
+  void waitForTask(TaskBase* task, bool help = false);
+  SpawnTarget spawnTarget(TaskBase* task);
+  void waitForAll();
+  void requireWorkers() const;
+  void armTimer(uint32_t id, std::chrono::steady_clock::time_point due);
+  void onTimer(uint32_t id, uint64_t generation);
+  bool restartPeriodic(uint32_t id);
+  bool dropTimer(uint32_t id);
+
+  template <typename... Args>
+  auto addTimed(TimerKind kind, std::chrono::steady_clock::duration interval,
+                Args&&... args) {
+    requireWorkers();
+    next_timer_ = kind;
+    next_interval_ = interval;
+    try {
+      auto task = add(std::forward<Args>(args)...);
+      next_timer_ = NO_TIMER;
+      return task;
+    } catch (...) {
+      next_timer_ = NO_TIMER;
+      throw;
+    }
+  }
+  void notifyWhenDrained(Function<void(std::exception_ptr)> callback);
+  void checkStragglers();
+  StragglerReport describeStraggler(const Watchdog::Candidate& candidate) const;
+
   template <typename T> 
   void executeTask(std::shared_ptr<Task<T>> task) {
     if (task->IsExecuted()) {
@@ -253,4 +757,13 @@ private:
            std::shared_ptr<TaskBase> start,
            std::unordered_map<TaskBase *, VISIT>& state);
   void TopSort();
+  void ensureOrder();
+  void buildTable();
+  void insertEdge(uint32_t from, uint32_t to);
+  TaskSlot slotOf(uint32_t id) const {
+    TaskBase* task = by_id_[id];
+    return TaskSlot{task->run_, task, task->status_};
+  }
+  void PrioritySort();
+  void MemorySort();
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "spill.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t PageAligned(uint64_t size) {
+  static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  return (size + page - 1) / page * page;
+}
+
+}
+
+SpillFile::Mapping::~Mapping() {
+  munmap(address_, length_);
+}
+
+SpillFile::SpillFile(const std::string& directory) {
+#ifdef O_TMPFILE
+  fd_ = open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+  if (fd_ < 0) {
+    std::string pattern = directory + "/scheduler-spill-XXXXXX";
+    fd_ = mkstemp(pattern.data());
+    if (fd_ >= 0) {
+      unlink(pattern.c_str());
+    }
+  }
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "spill file in " + directory);
+  }
+}
+
+SpillFile::~SpillFile() {
+  close(fd_);
+}
+
+SpillFile::Extent SpillFile::Allocate(size_t size) {
+  Extent extent{end_, size};
+  uint64_t end = end_ + PageAligned(size);
+  // Reserves the blocks: a sparse extent that the disk cannot back would
+  // raise SIGBUS when Save writes through the mapping.
+  int error = posix_fallocate(fd_, static_cast<off_t>(end_), static_cast<off_t>(end - end_));
+  if (error != 0) {
+    throw std::system_error(error, std::generic_category(), "growing spill file");
+  }
+  end_ = end;
+  live_ += 1;
+  return extent;
+}
+
+SpillFile::Mapping SpillFile::Map(const Extent& extent, bool writable) const {
+  int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* address = mmap(nullptr, extent.size, protection, MAP_SHARED, fd_,
+                       static_cast<off_t>(extent.offset));
+  if (address == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "mapping spill file");
+  }
+  return Mapping(address, extent.size);
+}
+
+void SpillFile::Release(const Extent& extent) {
+  if (--live_ == 0 && ftruncate(fd_, 0) == 0) {
+    end_ = 0;
+    return;
+  }
+#ifdef FALLOC_FL_PUNCH_HOLE
+  // Gives the disk space back while later extents are still live.
+  fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(extent.offset),
+            static_cast<off_t>(PageAligned(extent.size)));
+#endif
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// How a result type is written to a spill file and read back. Results whose
+// type has no serializer never spill and do not count against the budget.
+// Specialize for your own types; Size is the byte count that is budgeted.
+template <typename T, typename = void>
+struct ResultSerializer {
+  static constexpr bool kSpillable = false;
+};
+
+template <typename T>
+struct ResultSerializer<std::vector<T>, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+  static constexpr bool kSpillable = true;
+
+  static size_t Size(const std::vector<T>& value) { return value.size() * sizeof(T); }
+
+  static void Save(const std::vector<T>& value, std::byte* out) {
+    std::memcpy(out, value.data(), Size(value));
+  }
+
+  static std::vector<T> Load(const std::byte* in, size_t size) {
+    std::vector<T> value(size / sizeof(T));
+    std::memcpy(value.data(), in, size);
+    return value;
+  }
+};
+
+template <>
+struct ResultSerializer<std::string> {
+  static constexpr bool kSpillable = true;
+
+  static size_t Size(const std::string& value) { return value.size(); }
+
+  static void Save(const std::string& value, std::byte* out) {
+    std::memcpy(out, value.data(), value.size());
+  }
+
+  static std::string Load(const std::byte* in, size_t size) {
+    return std::string(reinterpret_cast<const char*>(in), size);
+  }
+};
+
+// An unlinked file that holds spilled results. Each result gets its own
+// page-aligned extent so it can be mapped on its own; the file is truncated
+// once nothing in it is live.
+class SpillFile {
+public:
+  struct Extent {
+    uint64_t offset = 0;
+    size_t size = 0;
+  };
+
+  // A mapped extent, unmapped on destruction.
+  class Mapping {
+  public:
+    Mapping(void* address, size_t length) : address_(address), length_(length) {}
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping();
+
+    std::byte* data() const { return static_cast<std::byte*>(address_); }
+
+  private:
+    void* address_;
+    size_t length_;
+  };
+
+  // Throws std::system_error if no file can be created in `directory`.
+  explicit SpillFile(const std::string& directory);
+
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+
+  ~SpillFile();
+
+  // Reserves `size` bytes of disk at the end of the file; `size` must not be
+  // zero. Throws std::system_error if the disk cannot hold them.
+  Extent Allocate(size_t size);
+
+  Mapping Map(const Extent& extent, bool writable) const;
+
+  void Release(const Extent& extent);
+
+private:
+  int fd_ = -1;
+  uint64_t end_ = 0;
+  size_t live_ = 0;
+};
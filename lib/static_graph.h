@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+template <typename... Ts> struct TypeList {};
+
+template <typename List, typename T> struct type_list_contains;
+template <typename T, typename... Ts>
+struct type_list_contains<TypeList<Ts...>, T>
+    : std::bool_constant<(std::is_same_v<T, Ts> || ...)> {};
+
+template <typename List, typename T> struct type_list_append;
+template <typename T, typename... Ts>
+struct type_list_append<TypeList<Ts...>, T> {
+  using type = TypeList<Ts..., T>;
+};
+
+template <typename List, typename T> struct type_list_index;
+template <typename T, typename... Ts>
+struct type_list_index<TypeList<T, Ts...>, T> : std::integral_constant<size_t, 0> {};
+template <typename T, typename U, typename... Ts>
+struct type_list_index<TypeList<U, Ts...>, T>
+    : std::integral_constant<size_t, 1 + type_list_index<TypeList<Ts...>, T>::value> {};
+
+template <size_t Index, typename T>
+struct StaticInput {
+  using inputs = TypeList<>;
+  using result_type = T;
+
+  template <typename Results, typename Args>
+  static result_type Compute(const Results&, const Args& args) {
+    return std::get<Index>(args);
+  }
+};
+
+template <auto Fn, typename... Inputs>
+struct StaticNode {
+  using inputs = TypeList<Inputs...>;
+  using result_type = std::decay_t<
+      std::invoke_result_t<decltype(Fn), const typename Inputs::result_type&...>>;
+
+  template <typename Order, typename Results, typename Args>
+  static result_type Compute(const Results& results, const Args&) {
+    return Fn(std::get<type_list_index<Order, Inputs>::value>(results)...);
+  }
+};
+
+template <typename Visited, typename... Nodes> struct static_visit_all;
+
+template <typename Visited, typename Node,
+          bool Seen = type_list_contains<Visited, Node>::value>
+struct static_visit {
+  using type = Visited;
+};
+
+template <typename Visited, typename Node>
+struct static_visit<Visited, Node, false> {
+  template <typename List> struct expand;
+  template <typename... Inputs> struct expand<TypeList<Inputs...>> {
+    using type = typename static_visit_all<Visited, Inputs...>::type;
+  };
+
+  using type = typename type_list_append<
+      typename expand<typename Node::inputs>::type, Node>::type;
+};
+
+template <typename Visited>
+struct static_visit_all<Visited> {
+  using type = Visited;
+};
+
+template <typename Visited, typename Node, typename... Nodes>
+struct static_visit_all<Visited, Node, Nodes...> {
+  using type = typename static_visit_all<
+      typename static_visit<Visited, Node>::type, Nodes...>::type;
+};
+
+template <typename... Targets>
+class TStaticGraph {
+public:
+  using order = typename static_visit_all<TypeList<>, Targets...>::type;
+
+  template <typename Node>
+  static constexpr size_t position() {
+    return type_list_index<order, Node>::value;
+  }
+
+  template <typename... Args>
+  void executeAll(const Args&... args) {
+    run(std::forward_as_tuple(args...), std::make_index_sequence<size()>());
+  }
+
+  template <typename Node>
+  const typename Node::result_type& getResult() const {
+    return std::get<position<Node>()>(results_);
+  }
+
+  static constexpr size_t size() { return size_impl(order()); }
+
+private:
+  template <typename... Nodes>
+  static constexpr size_t size_impl(TypeList<Nodes...>) { return sizeof...(Nodes); }
+
+  template <typename List> struct results_of;
+  template <typename... Nodes> struct results_of<TypeList<Nodes...>> {
+    using type = std::tuple<typename Nodes::result_type...>;
+  };
+
+  template <size_t I, typename List> struct node_at;
+  template <size_t I, typename... Nodes> struct node_at<I, TypeList<Nodes...>> {
+    using type = std::tuple_element_t<I, std::tuple<Nodes...>>;
+  };
+
+  template <typename Node, typename Args>
+  static typename Node::result_type compute(const typename results_of<order>::type& results,
+                                            const Args& args) {
+    if constexpr (requires { Node::template Compute<order>(results, args); }) {
+      return Node::template Compute<order>(results, args);
+    } else {
+      return Node::Compute(results, args);
+    }
+  }
+
+  template <typename Args, size_t... I>
+  void run(const Args& args, std::index_sequence<I...>) {
+    ((std::get<I>(results_) =
+          compute<typename node_at<I, order>::type>(results_, args)), ...);
+  }
+
+  typename results_of<order>::type results_;
+};
@@ -0,0 +1,32 @@
+#include "stats.h"
+
+void StatsShard::Snapshot(const std::atomic<Histogram*>& slot, LatencyHistogram& into) {
+  const Histogram* histogram = slot.load(std::memory_order_acquire);
+  if (histogram == nullptr) {
+    return;
+  }
+  uint64_t total = 0;
+  for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+    uint64_t count = histogram->counts[i].load(std::memory_order_relaxed);
+    into.counts_[i] += count;
+    total += count;
+  }
+  if (total == 0) {
+    return;
+  }
+  into.total_ += total;
+  into.sum_ += histogram->sum.load(std::memory_order_relaxed);
+  into.min_ = std::min(into.min_, histogram->min.load(std::memory_order_relaxed));
+  into.max_ = std::max(into.max_, histogram->max.load(std::memory_order_relaxed));
+}
+
+void StatsShard::AddTo(SchedulerStats& stats) const {
+  stats.tasks_executed += executed_.load(std::memory_order_relaxed);
+  stats.tasks_failed += failed_.load(std::memory_order_relaxed);
+  stats.task_time += std::chrono::nanoseconds(task_ns_.load(std::memory_order_relaxed));
+  stats.overhead_time += std::chrono::nanoseconds(overhead_ns_.load(std::memory_order_relaxed));
+  stats.topsorts += topsorts_.load(std::memory_order_relaxed);
+  stats.topsort_time += std::chrono::nanoseconds(topsort_ns_.load(std::memory_order_relaxed));
+  Snapshot(durations_, stats.task_durations);
+  Snapshot(depths_, stats.ready_queue_depths);
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Build with -DSCHEDULER_STATS=0 to compile the instrumentation out.
+#ifndef SCHEDULER_STATS
+#define SCHEDULER_STATS 1
+#endif
+
+inline constexpr bool kStatsEnabled = SCHEDULER_STATS != 0;
+
+// A clock read costs as much as a small task, so counts are exact but only
+// every kStatsSampleEvery-th run per thread is timed; time totals are scaled.
+inline constexpr uint64_t kStatsSampleEvery = 16;
+static_assert((kStatsSampleEvery & (kStatsSampleEvery - 1)) == 0);
+
+inline int64_t StatsNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Counters below have a single writer, so a relaxed load and store is enough
+// and readers never see a torn value.
+inline void StatsAdd(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Log-linear histogram in the style of HdrHistogram: 16 linear sub-buckets per
+// power of two, so any recorded value is reported within 1/16 of itself.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 4;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBits;
+  static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+  static size_t BucketOf(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    int shift = std::bit_width(value) - 1 - kSubBits;
+    return (shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+  }
+
+  static uint64_t LowestOf(size_t bucket) {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    size_t shift = bucket / kSubBuckets - 1;
+    return (kSubBuckets + bucket % kSubBuckets) << shift;
+  }
+
+  static uint64_t HighestOf(size_t bucket) {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    return LowestOf(bucket) + (uint64_t{1} << (bucket / kSubBuckets - 1)) - 1;
+  }
+
+  void Record(uint64_t value, uint64_t count = 1) {
+    counts_[BucketOf(value)] += count;
+    total_ += count;
+    sum_ += value * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return total_; }
+
+  uint64_t Min() const { return total_ == 0 ? 0 : min_; }
+
+  uint64_t Max() const { return max_; }
+
+  double Mean() const { return total_ == 0 ? 0.0 : static_cast<double>(sum_) / total_; }
+
+  // Highest value equivalent to the recorded value at `percentile` (0-100].
+  uint64_t ValueAtPercentile(double percentile) const {
+    if (total_ == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total_ + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, total_);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::min(HighestOf(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  uint64_t CountAt(size_t bucket) const { return counts_[bucket]; }
+
+private:
+  friend class StatsShard;
+
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t total_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
+struct WorkerStats {
+  // Jobs taken; busy time is estimated from sampled jobs.
+  uint64_t jobs = 0;
+  std::chrono::nanoseconds busy{0};
+  std::chrono::nanoseconds idle{0};
+  uint64_t local_steals = 0;
+  uint64_t remote_steals = 0;
+};
+
+struct SchedulerStats {
+  size_t tasks_added = 0;
+  uint64_t tasks_executed = 0;
+  uint64_t tasks_failed = 0;
+  uint64_t topsorts = 0;
+  std::chrono::nanoseconds topsort_time{0};
+  // Time inside task callables, and scheduler time spent around them.
+  std::chrono::nanoseconds task_time{0};
+  std::chrono::nanoseconds overhead_time{0};
+  // Eager only: ready-queue depth now and as seen by sampled task starts.
+  size_t ready_queue_depth = 0;
+  LatencyHistogram ready_queue_depths;
+  // Run time of the sampled tasks, in nanoseconds.
+  LatencyHistogram task_durations;
+  // Per worker of the scheduler's pool; a shared pool reports all its users.
+  std::vector<WorkerStats> workers;
+  // Results moved out under SchedulerOptions::result_budget, and read back.
+  uint64_t results_spilled = 0;
+  uint64_t results_restored = 0;
+  uint64_t bytes_spilled = 0;
+};
+
+// One thread's counters for one scheduler. Only the owning thread writes.
+// A histogram is allocated on its first record, so threads that never time a
+// run of this scheduler pay about a hundred bytes instead of two histograms.
+class StatsShard {
+public:
+  StatsShard() = default;
+  StatsShard(const StatsShard&) = delete;
+  StatsShard& operator=(const StatsShard&) = delete;
+
+  ~StatsShard() {
+    delete durations_.load(std::memory_order_relaxed);
+    delete depths_.load(std::memory_order_relaxed);
+  }
+
+  // True when the next run should be timed.
+  bool Sample() { return (runs_++ & (kStatsSampleEvery - 1)) == 0; }
+
+  void RecordRun(bool failed) { StatsAdd(failed ? failed_ : executed_); }
+
+  void RecordSample(int64_t nanoseconds) {
+    StatsAdd(task_ns_, nanoseconds * kStatsSampleEvery);
+    Record(durations_, static_cast<uint64_t>(nanoseconds));
+  }
+
+  void RecordOverhead(int64_t nanoseconds) {
+    StatsAdd(overhead_ns_, static_cast<uint64_t>(std::max<int64_t>(nanoseconds, 0)));
+  }
+
+  void RecordOverheadSample(int64_t nanoseconds) {
+    RecordOverhead(nanoseconds * kStatsSampleEvery);
+  }
+
+  void RecordTopSort(int64_t nanoseconds) {
+    StatsAdd(topsorts_);
+    StatsAdd(topsort_ns_, nanoseconds);
+  }
+
+  void RecordQueueDepth(size_t depth) { Record(depths_, depth); }
+
+  uint64_t TaskNanoseconds() const { return task_ns_.load(std::memory_order_relaxed); }
+
+  void AddTo(SchedulerStats& stats) const;
+
+private:
+  struct Histogram {
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> counts{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+  };
+
+  // Published with release so a reader sees the zeroed counts.
+  static void Record(std::atomic<Histogram*>& slot, uint64_t value) {
+    Histogram* histogram = slot.load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+      histogram = new Histogram;
+      slot.store(histogram, std::memory_order_release);
+    }
+    StatsAdd(histogram->counts[LatencyHistogram::BucketOf(value)]);
+    StatsAdd(histogram->sum, value);
+    if (value < histogram->min.load(std::memory_order_relaxed)) {
+      histogram->min.store(value, std::memory_order_relaxed);
+    }
+    if (value > histogram->max.load(std::memory_order_relaxed)) {
+      histogram->max.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  static void Snapshot(const std::atomic<Histogram*>& slot, LatencyHistogram& into);
+
+  uint64_t runs_ = 0;
+  std::atomic<uint64_t> executed_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<uint64_t> task_ns_{0};
+  std::atomic<uint64_t> overhead_ns_{0};
+  std::atomic<uint64_t> topsorts_{0};
+  std::atomic<uint64_t> topsort_ns_{0};
+  std::atomic<Histogram*> durations_{nullptr};
+  std::atomic<Histogram*> depths_{nullptr};
+};
+
+// Records one run when it leaves scope; the run counts as failed unless
+// Succeeded() was reached.
+class RunTimer {
+public:
+  explicit RunTimer(StatsShard& shard)
+      : shard_(shard), start_(shard.Sample() ? StatsNow() : 0) {}
+
+  RunTimer(const RunTimer&) = delete;
+  RunTimer& operator=(const RunTimer&) = delete;
+
+  ~RunTimer() {
+    shard_.RecordRun(failed_);
+    if (start_ != 0) {
+      shard_.RecordSample(StatsNow() - start_);
+    }
+  }
+
+  void Succeeded() { failed_ = false; }
+
+private:
+  StatsShard& shard_;
+  int64_t start_;
+  bool failed_ = true;
+};
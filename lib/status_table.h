@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Dense per-task status bytes indexed by task id. Storage grows in fixed
+// chunks so a slot never moves once handed out.
+class StatusTable {
+public:
+  static constexpr size_t kChunkSize = 4096;
+
+  uint32_t Append() {
+    if (size_ % kChunkSize == 0) {
+      chunks_.push_back(std::make_unique<std::atomic<uint8_t>[]>(kChunkSize));
+    }
+    return static_cast<uint32_t>(size_++);
+  }
+
+  std::atomic<uint8_t>& operator[](size_t id) {
+    return chunks_[id / kChunkSize][id % kChunkSize];
+  }
+
+  const std::atomic<uint8_t>& operator[](size_t id) const {
+    return chunks_[id / kChunkSize][id % kChunkSize];
+  }
+
+  size_t Size() const { return size_; }
+
+private:
+  std::vector<std::unique_ptr<std::atomic<uint8_t>[]>> chunks_;
+  size_t size_ = 0;
+};
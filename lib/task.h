@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <expected>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "spill.h"
+
 template <typename T>
 struct is_member_function_pointer : std::is_member_function_pointer<T> {};
 
@@ -29,6 +35,10 @@ public:
     CallableBase<ReturnType>* clone() const override {
         return new CallableHolder(callable_);
     }
+
+    CallableType& callable() {
+        return callable_;
+    }
     
 private:
     CallableType callable_;
@@ -81,34 +91,346 @@ public:
     explicit operator bool() const {
         return impl_ != nullptr;
     }
+
+    // Unchecked: the caller must know the stored callable is a CallableType.
+    template <typename CallableType>
+    CallableType* target() {
+        return &static_cast<CallableHolder<ReturnType, CallableType>*>(impl_)->callable();
+    }
     
 private:
     CallableBase<ReturnType>* impl_;
 };
 
+template <typename ReturnType, typename... Args>
+class CallableBase<ReturnType(Args...)> {
+public:
+    virtual ~CallableBase() = default;
+    virtual ReturnType invoke(Args... args) = 0;
+    virtual CallableBase* clone() const = 0;
+};
+
+template <typename ReturnType, typename... Args, typename CallableType>
+class CallableHolder<ReturnType(Args...), CallableType>
+    : public CallableBase<ReturnType(Args...)> {
+public:
+    explicit CallableHolder(CallableType callable) : callable_(std::move(callable)) {}
+
+    ReturnType invoke(Args... args) override {
+        return callable_(std::forward<Args>(args)...);
+    }
+
+    CallableBase<ReturnType(Args...)>* clone() const override {
+        return new CallableHolder(callable_);
+    }
+
+private:
+    CallableType callable_;
+};
+
+template <typename ReturnType, typename... Args>
+class Function<ReturnType(Args...)> {
+public:
+    Function() : impl_(nullptr) {}
+
+    template <typename CallableType>
+    Function(CallableType callable)
+        : impl_(new CallableHolder<ReturnType(Args...), CallableType>(std::move(callable))) {}
+
+    Function(const Function& other)
+        : impl_(other.impl_ ? other.impl_->clone() : nullptr) {}
+
+    Function(Function&& other) noexcept : impl_(other.impl_) {
+        other.impl_ = nullptr;
+    }
+
+    Function& operator=(const Function& other) {
+        if (this != &other) {
+            delete impl_;
+            impl_ = other.impl_ ? other.impl_->clone() : nullptr;
+        }
+        return *this;
+    }
+
+    Function& operator=(Function&& other) noexcept {
+        if (this != &other) {
+            delete impl_;
+            impl_ = other.impl_;
+            other.impl_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~Function() {
+        delete impl_;
+    }
+
+    ReturnType operator()(Args... args) {
+        if (!impl_) {
+            throw std::bad_function_call();
+        }
+        return impl_->invoke(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const {
+        return impl_ != nullptr;
+    }
+
+private:
+    CallableBase<ReturnType(Args...)>* impl_;
+};
+
+template <typename T> struct is_expected : std::false_type {};
+template <typename T, typename E>
+struct is_expected<std::expected<T, E>> : std::true_type {};
+
+// Error-as-value results. A callable that accepts its arguments as given sees
+// std::expected results as-is; otherwise every expected argument is unwrapped
+// to its value, the first error short-circuits the call, and the dependent's
+// result is lifted to std::expected carrying that error.
+template <typename Callable, typename... Args>
+struct task_invoke {
+  template <typename Arg> struct unwrap {
+    using type = Arg;
+  };
+  template <typename T, typename E> struct unwrap<std::expected<T, E>> {
+    using type = const T&;
+  };
+
+  template <typename... Ts> struct first_error;
+  template <typename T, typename... Ts> struct first_error<T, Ts...> : first_error<Ts...> {};
+  template <typename T, typename E, typename... Ts>
+  struct first_error<std::expected<T, E>, Ts...> {
+    using type = E;
+  };
+
+  template <typename R, typename E> struct lift {
+    using type = std::expected<R, E>;
+  };
+  template <typename T, typename E, typename F> struct lift<std::expected<T, F>, E> {
+    using type = std::expected<T, F>;
+  };
+
+  static constexpr bool kUnwrap = !std::is_invocable_v<Callable&, Args...> &&
+                                  (is_expected<std::decay_t<Args>>::value || ...);
+
+  template <bool Unwrap, typename = void> struct result {
+    using type = std::invoke_result_t<Callable&, Args...>;
+  };
+  template <typename Dummy> struct result<true, Dummy> {
+    using type = typename lift<
+        std::invoke_result_t<Callable&, typename unwrap<std::decay_t<Args>>::type...>,
+        typename first_error<std::decay_t<Args>...>::type>::type;
+  };
+
+  using type = typename result<kUnwrap>::type;
+};
+
+template <typename Callable, typename... Args>
+using task_result_t = typename task_invoke<Callable, Args...>::type;
+
+template <typename R, typename Arg>
+bool propagateError(const Arg& arg, std::optional<R>& failure) {
+  if constexpr (is_expected<Arg>::value) {
+    if (!arg.has_value()) {
+      failure.emplace(std::unexpect, arg.error());
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Arg>
+decltype(auto) unwrapValue(Arg&& arg) {
+  if constexpr (is_expected<std::decay_t<Arg>>::value) {
+    return *std::as_const(arg);
+  } else {
+    return std::forward<Arg>(arg);
+  }
+}
+
+template <typename R, typename Callable, typename... Args>
+R invokeTask(const Callable& callable, Args&&... args) {
+  if constexpr (!task_invoke<const Callable, Args&&...>::kUnwrap) {
+    return callable(std::forward<Args>(args)...);
+  } else {
+    std::optional<R> failure;
+    if ((propagateError(args, failure) || ...)) {
+      return std::move(*failure);
+    }
+    using Raw = std::invoke_result_t<const Callable&, decltype(unwrapValue(std::forward<Args>(args)))...>;
+    if constexpr (std::is_void_v<Raw>) {
+      callable(unwrapValue(std::forward<Args>(args))...);
+      return R();
+    } else {
+      return R(callable(unwrapValue(std::forward<Args>(args))...));
+    }
+  }
+}
+
+class TTaskScheduler;
+class TaskBase;
+
+// Holds spilled results to a budget. Every result read back from a spill
+// file goes through its owner, so the bytes are counted where they land.
+class SpillOwner {
+public:
+  virtual void Restore(TaskBase* task) = 0;
+
+protected:
+  ~SpillOwner() = default;
+};
+
 template <typename T> class FutureResult;
+template <typename T> class Channel;
+template <typename T> class StreamResult;
 
-class TaskBase {
+class TaskBase : public std::enable_shared_from_this<TaskBase> {
 public:
-  TaskBase() : executed_(false) {}
+  using RunFunction = void (*)(TaskBase*);
+
+  // Bits 0, 6 and 7 belong to the task; the scheduler owns the bits between.
+  static constexpr uint8_t kExecuted = 1;
+  static constexpr uint8_t kWaiting = 0x40;
+  static constexpr uint8_t kRunning = 0x80;
+
+  // Blocks until the status byte changes from `status`. Sets kWaiting first so
+  // publishers know to notify; returns false if the byte already moved on.
+  static bool waitStatus(std::atomic<uint8_t>& slot, uint8_t status) {
+    if ((status & kWaiting) == 0 &&
+        !slot.compare_exchange_strong(status, status | kWaiting, std::memory_order_acquire)) {
+      return false;
+    }
+    slot.wait(status | kWaiting, std::memory_order_acquire);
+    return true;
+  }
+
+  // Publishes bits that waiters may be blocked on.
+  static void notifyStatus(std::atomic<uint8_t>& slot, uint8_t previous) {
+    if ((previous & kWaiting) != 0) {
+      slot.fetch_and(static_cast<uint8_t>(~kWaiting), std::memory_order_release);
+      slot.notify_all();
+    }
+  }
+
+  TaskBase()
+      : run_(nullptr), own_status_(0), status_(&own_status_), own_edges_(0),
+        edge_epoch_(&own_edges_), id_(0) {}
 
   virtual ~TaskBase() {}
 
   virtual void Execute() = 0;
 
-  bool IsExecuted() const { return executed_; }
+  bool IsExecuted() const {
+    return (status_->load(std::memory_order_acquire) & kExecuted) != 0;
+  }
+
+  void Reset() { status_->fetch_and(static_cast<uint8_t>(~kExecuted), std::memory_order_release); }
+
+  // Runs only this task's callable; dependencies must already be executed.
+  RunFunction Runner() const { return run_; }
 
   void AddDependendTask(std::shared_ptr<TaskBase> task) {
-    dependencies_.push_back(task);
+    dependencies_.push_back(std::move(task));
+    edge_epoch_->fetch_add(1, std::memory_order_relaxed);
   }
 
-  const std::vector<std::shared_ptr<TaskBase>> GetDependecies() {
+  const std::vector<std::shared_ptr<TaskBase>>& GetDependecies() const {
     return dependencies_;
   }
 
+  // Spilling, for results with a ResultSerializer: the serialized size, or 0
+  // if the result cannot spill; moving the result out to `file`; and bringing
+  // it back. Reading a spilled result restores it through the spill owner.
+  virtual size_t ResultBytes() const { return 0; }
+  // What the result occupies: the object itself plus what its serializer
+  // reports beyond it. Before the first run that is usually just the object.
+  virtual size_t ResultFootprint() const { return 0; }
+  virtual void SpillResult(const std::shared_ptr<SpillFile>&) {}
+  virtual void RestoreResult() {}
+
+  bool IsSpilled() const { return spill_file_ != nullptr; }
+
+  // Forgets a spilled result that is about to be recomputed.
+  void DropSpill() {
+    if (spill_file_) {
+      spill_file_->Release(spill_extent_);
+      spill_file_.reset();
+    }
+  }
+
 protected:
-  bool executed_;
+  // Claims the run for the calling thread. If another thread is running the
+  // task this blocks until it publishes, and returns false once executed.
+  bool beginRun() {
+    uint8_t status = status_->load(std::memory_order_acquire);
+    while (true) {
+      if ((status & kExecuted) != 0) {
+        return false;
+      }
+      if ((status & kRunning) != 0) {
+        waitStatus(*status_, status);
+        status = status_->load(std::memory_order_acquire);
+        continue;
+      }
+      if (status_->compare_exchange_weak(status, status | kRunning,
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+        return true;
+      }
+    }
+  }
+
+  void endRun(bool executed) {
+    uint8_t previous;
+    if (executed) {
+      previous = status_->fetch_xor(kRunning | kExecuted, std::memory_order_release);
+    } else {
+      previous = status_->fetch_and(static_cast<uint8_t>(~kRunning), std::memory_order_release);
+    }
+    notifyStatus(*status_, previous);
+  }
+
+  void restoreSpilled() {
+    if (spill_owner_) {
+      spill_owner_->Restore(this);
+    } else {
+      RestoreResult();
+    }
+  }
+
   std::vector<std::shared_ptr<TaskBase>> dependencies_;
+  RunFunction run_;
+  std::shared_ptr<SpillFile> spill_file_;
+  SpillFile::Extent spill_extent_;
+  SpillOwner* spill_owner_ = nullptr;
+
+private:
+  friend class TTaskScheduler;
+
+  // The executed bit lives in the owning scheduler's status table while the
+  // task is registered, and in own_status_ otherwise. Edge insertions are
+  // counted on the owner's epoch the same way, so that scheduler can tell
+  // its cached order is stale without seeing edges added elsewhere.
+  void bindStatus(std::atomic<uint8_t>* slot, std::atomic<uint64_t>* edges) {
+    slot->store(own_status_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    status_ = slot;
+    edge_epoch_ = edges;
+  }
+
+  void unbindStatus() {
+    own_status_.store(status_->load(std::memory_order_acquire) & kExecuted,
+                      std::memory_order_relaxed);
+    status_ = &own_status_;
+    edge_epoch_ = &own_edges_;
+    spill_owner_ = nullptr;
+  }
+
+  std::atomic<uint8_t> own_status_;
+  std::atomic<uint8_t>* status_;
+  std::atomic<uint64_t> own_edges_;
+  std::atomic<uint64_t>* edge_epoch_;
+  uint32_t id_;
 };
 
 template <typename ReturnType> 
@@ -117,79 +439,71 @@ public:
   template <typename Callable,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable)
-      : callable_([callable = std::forward<Callable>(callable)]() {
+      : callable_(bindCallable([callable = std::forward<Callable>(callable)]() {
           return callable();
-        }) {}
+        })) {}
 
   template <typename Callable, typename Arg1,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable, Arg1&& arg1)
-      : callable_([callable = std::forward<Callable>(callable),
+      : callable_(bindCallable([callable = std::forward<Callable>(callable),
                    arg1 = std::forward<Arg1>(arg1)]() {
-          return callable(getValue(arg1));
-        }) {}
+          return invokeTask<ReturnType>(callable, getValue(arg1));
+        })) {}
 
   template <typename Callable, typename Arg1, typename Arg2,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable, Arg1&& arg1, Arg2&& arg2)
-      : callable_([callable = std::forward<Callable>(callable),
+      : callable_(bindCallable([callable = std::forward<Callable>(callable),
                    arg1 = std::forward<Arg1>(arg1),
                    arg2 = std::forward<Arg2>(arg2)]() {
-          return callable(getValue(arg1), getValue(arg2));
-        }) {}
+          return invokeTask<ReturnType>(callable, getValue(arg1), getValue(arg2));
+        })) {}
 
   template <typename ClassType>
   Task(ReturnType (ClassType::*method)() const, ClassType& instance)
-      : callable_([method, &instance]() { return (instance.*method)(); }) {}
+      : callable_(bindCallable([method, &instance]() { return (instance.*method)(); })) {}
         
   template <typename ClassType, typename T>
   Task(ReturnType (ClassType::*method)(T) const, ClassType &instance,
        const FutureResult<T> &future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           return (instance.*method)(getValue(future));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename T>
   Task(ReturnType (ClassType::*method)(const T&) const, ClassType &instance,
         const FutureResult<T>& future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           return (instance.*method)(getValue(future));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename T>
   Task(ReturnType (ClassType::*method)(const T&), ClassType &instance,
         const FutureResult<T>& future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           return (instance.*method)(getValue(future));
-        }) {}
+        })) {}
   
   template <typename ClassType, typename MethodArg, typename Arg1>
   Task(ReturnType (ClassType::*method)(MethodArg), ClassType& instance, Arg1&& arg1)
-      : callable_([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
+      : callable_(bindCallable([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
           return (instance.*method)(getValue(arg1));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename MethodArg, typename Arg1>
   Task(ReturnType (ClassType::*method)(MethodArg) const, ClassType& instance,
        Arg1&& arg1)
-      : callable_([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
+      : callable_(bindCallable([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
           return (instance.*method)(getValue(arg1));
-        }) {}
+        })) {}
 
   void Execute() override {
     if (!IsExecuted()) {
-      try {
-        if (!dependencies_.empty()) {
-          for (auto& elem: dependencies_) {
-            elem->Execute();
-          }
-        }
-        result_ = callable_();
-        executed_ = true;
-      }
-      catch(...) {
-        throw;
+      for (auto& elem: dependencies_) {
+        elem->Execute();
       }
+      run_(this);
     }
   }
 
@@ -197,20 +511,95 @@ public:
     if (!IsExecuted()) {
       Execute();
     }
-    return result_;
+    return resident();
+  }
+
+  size_t ResultBytes() const override {
+    if constexpr (ResultSerializer<ReturnType>::kSpillable) {
+      return spill_file_ ? spill_extent_.size : ResultSerializer<ReturnType>::Size(result_);
+    } else {
+      return 0;
+    }
+  }
+
+  size_t ResultFootprint() const override { return sizeof(ReturnType) + ResultBytes(); }
+
+  void SpillResult(const std::shared_ptr<SpillFile>& file) override {
+    if constexpr (ResultSerializer<ReturnType>::kSpillable) {
+      size_t size = ResultSerializer<ReturnType>::Size(result_);
+      if (spill_file_ || size == 0) {
+        return;
+      }
+      SpillFile::Extent extent = file->Allocate(size);
+      try {
+        SpillFile::Mapping mapping = file->Map(extent, true);
+        ResultSerializer<ReturnType>::Save(result_, mapping.data());
+      } catch (...) {
+        file->Release(extent);
+        throw;
+      }
+      result_ = ReturnType();
+      spill_file_ = file;
+      spill_extent_ = extent;
+    }
+  }
+
+  void RestoreResult() override {
+    if constexpr (ResultSerializer<ReturnType>::kSpillable) {
+      if (!spill_file_) {
+        return;
+      }
+      {
+        SpillFile::Mapping mapping = spill_file_->Map(spill_extent_, false);
+        result_ = ResultSerializer<ReturnType>::Load(mapping.data(), spill_extent_.size);
+      }
+      DropSpill();
+    }
   }
 
-  
 private:
   Function<ReturnType> callable_;
   ReturnType result_;
   template <typename T> friend class FutureResult;
 
+  const ReturnType& resident() {
+    if (spill_file_) [[unlikely]] {
+      restoreSpilled();
+    }
+    return result_;
+  }
+
+  template <typename Bound>
+  Function<ReturnType> bindCallable(Bound bound) {
+    run_ = &runBound<Bound>;
+    return Function<ReturnType>(std::move(bound));
+  }
+
+  template <typename Bound>
+  static void runBound(TaskBase* base) {
+    Task* task = static_cast<Task*>(base);
+    if (!task->beginRun()) {
+      return;
+    }
+    try {
+      task->result_ = (*task->callable_.template target<Bound>())();
+    } catch (...) {
+      task->endRun(false);
+      throw;
+    }
+    task->endRun(true);
+  }
+
   template <typename T>
   static const T& getValue(const FutureResult<T> &future) {
     return future.get();
   }
 
+  template <typename T>
+  static Channel<T>& getValue(const StreamResult<T>& stream) {
+    return stream.channel();
+  }
+
   template <typename Arg> static Arg getValue(const Arg& arg) { return arg; }
 };
 
@@ -220,79 +609,71 @@ public:
   template <typename Callable,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable)
-      : callable_([callable = std::forward<Callable>(callable)]() {
+      : callable_(bindCallable([callable = std::forward<Callable>(callable)]() {
           callable();
-        }) {}
+        })) {}
 
   template <typename Callable, typename Arg1,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable, Arg1&& arg1)
-      : callable_([callable = std::forward<Callable>(callable),
+      : callable_(bindCallable([callable = std::forward<Callable>(callable),
                    arg1 = std::forward<Arg1>(arg1)]() {
           callable(getValue(arg1));
-        }) {}
+        })) {}
 
   template <typename Callable, typename Arg1, typename Arg2,
   typename = std::enable_if_t<!is_member_function_pointer<std::decay_t<Callable>>::value>>
   Task(Callable&& callable, Arg1&& arg1, Arg2&& arg2)
-      : callable_([callable = std::forward<Callable>(callable),
+      : callable_(bindCallable([callable = std::forward<Callable>(callable),
                    arg1 = std::forward<Arg1>(arg1),
                    arg2 = std::forward<Arg2>(arg2)]() {
           callable(getValue(arg1), getValue(arg2));
-        }) {}
+        })) {}
 
   template <typename ClassType>
   Task(void (ClassType::*method)() const, ClassType& instance)
-      : callable_([method, &instance]() { (instance.*method)(); }) {}
+      : callable_(bindCallable([method, &instance]() { (instance.*method)(); })) {}
         
   template <typename ClassType, typename T>
   Task(void (ClassType::*method)(T) const, ClassType &instance,
        const FutureResult<T> &future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           (instance.*method)(getValue(future));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename T>
   Task(void (ClassType::*method)(const T&) const, ClassType &instance,
         const FutureResult<T>& future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           (instance.*method)(getValue(future));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename T>
   Task(void (ClassType::*method)(const T&), ClassType &instance,
         const FutureResult<T>& future)
-      : callable_([method, &instance, future]() {
+      : callable_(bindCallable([method, &instance, future]() {
           (instance.*method)(getValue(future));
-        }) {}
+        })) {}
   
   template <typename ClassType, typename MethodArg, typename Arg1>
   Task(void (ClassType::*method)(MethodArg), ClassType& instance, Arg1&& arg1)
-      : callable_([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
+      : callable_(bindCallable([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
           (instance.*method)(getValue(arg1));
-        }) {}
+        })) {}
 
   template <typename ClassType, typename Arg1, typename MethodArg>
   Task(void (ClassType::*method)(MethodArg) const, ClassType& instance,
        Arg1&& arg1)
-      : callable_([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
+      : callable_(bindCallable([method, &instance, arg1 = std::forward<Arg1>(arg1)]() {
           (instance.*method)(getValue(arg1));
-        }) {}
+        })) {}
 
   void Execute() override {
     if (!IsExecuted()) {
-      try {
-        if (!dependencies_.empty()) {
-          for (auto& elem: dependencies_) {
-            elem->Execute();
-          }
-        }
-        callable_();
-        executed_ = true;
-      }
-      catch(...) {
-        throw;
+      for (auto& elem: dependencies_) {
+        elem->Execute();
       }
+      run_(this);
     }
   }
 
@@ -305,25 +686,82 @@ public:
 private:
   Function<void> callable_;
 
+  template <typename Bound>
+  Function<void> bindCallable(Bound bound) {
+    run_ = &runBound<Bound>;
+    return Function<void>(std::move(bound));
+  }
+
+  template <typename Bound>
+  static void runBound(TaskBase* base) {
+    Task* task = static_cast<Task*>(base);
+    if (!task->beginRun()) {
+      return;
+    }
+    try {
+      (*task->callable_.template target<Bound>())();
+    } catch (...) {
+      task->endRun(false);
+      throw;
+    }
+    task->endRun(true);
+  }
+
   template <typename T>
   static const T& getValue(const FutureResult<T> &future) {
     return future.get();
   }
 
+  template <typename T>
+  static Channel<T>& getValue(const StreamResult<T>& stream) {
+    return stream.channel();
+  }
+
   template <typename Arg> static Arg getValue(const Arg& arg) { return arg; }
 };
 
 
+// Non-owning view of a task's result. Copies never touch the task's
+// refcount. The producer lives as long as the scheduler it was added to, a
+// task that reads it, or a shared_ptr to it does; get() past all three is
+// undefined. Adding a reader takes the one reference its edge owns.
 template <typename T> class FutureResult {
 public:
   using value_type = T;
-  explicit FutureResult(std::shared_ptr<Task<T>> task) : task_(task) {}
+  explicit FutureResult(const std::shared_ptr<Task<T>>& task) : task_(task.get()) {}
 
-  const T& get() const { return task_->result_; }
+  const T& get() const { return task_->resident(); }
 
-  std::shared_ptr<Task<T>> getTask() const { return task_; }
+  std::shared_ptr<Task<T>> getTask() const {
+    return std::static_pointer_cast<Task<T>>(task_->shared_from_this());
+  }
 
 private:
-  std::shared_ptr<Task<T>> task_;
+  explicit FutureResult(Task<T>* task) : task_(task) {}
+
+  friend class TTaskScheduler;
+
+  Task<T>* task_;
+};
+
+// Trivially copyable typed handle: a slot index plus the generation of the
+// scheduler that issued it. Resolved through that scheduler.
+template <typename T> class TaskRef {
+public:
+  TaskRef() = default;
+
+  uint32_t Index() const { return index_; }
+
+  uint32_t Generation() const { return generation_; }
+
+  explicit operator bool() const { return generation_ != 0; }
+
+private:
+  TaskRef(uint32_t index, uint32_t generation) : index_(index), generation_(generation) {}
+
+  friend class TTaskScheduler;
+
+  uint32_t index_ = UINT32_MAX;
+  uint32_t generation_ = 0;
 };
 
@@ -0,0 +1,83 @@
+#include "task_context.h"
+
+#include <algorithm>
+
+void SpawnStateBase::Run(const SpawnTarget& target) {
+  {
+    TaskContext context(target);
+    try {
+      Invoke(context);
+      context.sync();
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+  }
+  done_.store(true, std::memory_order_release);
+  done_.notify_all();
+}
+
+TaskContext::~TaskContext() {
+  for (const auto& child : children_) {
+    // A child nobody has started is dropped rather than run for a failed task.
+    if (!child->Claim()) {
+      Await(*child);
+    }
+  }
+}
+
+void TaskContext::sync() {
+  std::exception_ptr error;
+  while (!children_.empty()) {
+    std::shared_ptr<SpawnStateBase> child = std::move(children_.back());
+    children_.pop_back();
+    Await(*child);
+    if (!error) {
+      error = child->Error();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskContext::Start(std::shared_ptr<SpawnStateBase> state) {
+  children_.push_back(state);
+  if (!target_.pool) {
+    state->Claim();
+    state->Run(target_);
+    return;
+  }
+  target_.executor->Spawn([state = std::move(state), target = target_] {
+    if (state->Claim()) {
+      state->Run(target);
+    }
+  }, target_.options);
+}
+
+void TaskContext::Forget(const SpawnStateBase* state) {
+  // Children are mostly waited on newest first.
+  auto it = std::find_if(children_.rbegin(), children_.rend(),
+                         [state](const auto& child) { return child.get() == state; });
+  if (it != children_.rend()) {
+    children_.erase(std::next(it).base());
+  }
+}
+
+void TaskContext::Await(SpawnStateBase& state) {
+  if (state.Claim()) {
+    state.Run(target_);
+    return;
+  }
+  if (state.Done()) {
+    return;
+  }
+  // Parks once nothing is left to help with; on a pool thread a spare serves
+  // the queues meanwhile.
+  while (!state.Done()) {
+    if (target_.pool->RunOne()) {
+      continue;
+    }
+    ThreadPool::Blocking blocking;
+    state.WaitDone();
+  }
+}
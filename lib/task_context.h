@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "executor.h"
+#include "thread_pool.h"
+
+class TaskContext;
+
+// Where a context sends its children: the running task's executor, at the
+// task's priority and deadline. Helping and parking go through the pool; a
+// null pool means a serial scheduler.
+struct SpawnTarget {
+  ThreadPool* pool = nullptr;
+  Executor* executor = nullptr;
+  JobOptions options;
+};
+
+// What a child spawned through a TaskContext shares with its handle. The
+// child is queued and may also be run by its parent: whoever claims it first
+// runs the body, and a queued job that lost the claim does nothing.
+class SpawnStateBase {
+public:
+  virtual ~SpawnStateBase() = default;
+
+  bool Claim() { return !claimed_.exchange(true, std::memory_order_acq_rel); }
+
+  // Runs the body with a context of its own, joining whatever it spawned.
+  void Run(const SpawnTarget& target);
+
+  bool Done() const { return done_.load(std::memory_order_acquire); }
+
+  void WaitDone() const { done_.wait(false, std::memory_order_acquire); }
+
+  const std::exception_ptr& Error() const { return error_; }
+
+protected:
+  virtual void Invoke(TaskContext& context) = 0;
+
+private:
+  std::atomic<bool> claimed_{false};
+  std::atomic<bool> done_{false};
+  std::exception_ptr error_;
+};
+
+template <typename T>
+class SpawnResult : public SpawnStateBase {
+public:
+  T Take() { return std::move(*value_); }
+
+protected:
+  std::optional<T> value_;
+};
+
+template <>
+class SpawnResult<void> : public SpawnStateBase {
+public:
+  void Take() {}
+};
+
+// A callable spawned as a child gets the child's own context if it takes one.
+template <typename Callable>
+using spawn_result_t = std::decay_t<typename std::conditional_t<
+    std::is_invocable_v<Callable&, TaskContext&>, std::invoke_result<Callable&, TaskContext&>,
+    std::invoke_result<Callable&>>::type>;
+
+template <typename T, typename Callable>
+class SpawnState : public SpawnResult<T> {
+public:
+  explicit SpawnState(Callable callable) : callable_(std::move(callable)) {}
+
+protected:
+  void Invoke(TaskContext& context) override {
+    if constexpr (std::is_void_v<T>) {
+      call(context);
+    } else {
+      this->value_.emplace(call(context));
+    }
+  }
+
+private:
+  decltype(auto) call(TaskContext& context) {
+    if constexpr (std::is_invocable_v<Callable&, TaskContext&>) {
+      return callable_(context);
+    } else {
+      return callable_();
+    }
+  }
+
+  Callable callable_;
+};
+
+// Handle on a spawned child; pass it to TaskContext::wait once.
+template <typename T>
+class Spawned {
+public:
+  Spawned() = default;
+
+  bool valid() const { return state_ != nullptr; }
+
+private:
+  friend class TaskContext;
+
+  explicit Spawned(std::shared_ptr<SpawnResult<T>> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<SpawnResult<T>> state_;
+};
+
+// Handed to a task callable that takes a TaskContext&: lets the running task
+// spawn children and join on them, fork-join style. A child is submitted
+// through the task's executor with the task's priority and deadline; on the
+// CPU pool it goes to the front of the calling worker's queue at that level,
+// so that worker takes its newest child first while idle workers steal the
+// oldest, largest ones. A tenant's children pass through its runtime. Waiting on
+// a child nobody has started runs it right away on the waiting thread;
+// otherwise the waiter runs other queued work and parks once none is left.
+// A serial scheduler runs each child as it is spawned.
+//
+// Children not waited on are joined when the task returns, and the task
+// fails with the first error among them. A context belongs to the thread
+// running its task and must not be shared.
+class TaskContext {
+public:
+  explicit TaskContext(SpawnTarget target) : target_(target) {}
+
+  TaskContext(const TaskContext&) = delete;
+  TaskContext& operator=(const TaskContext&) = delete;
+
+  // Only reached with children outstanding when the task threw: children
+  // already running are joined and their errors dropped; the rest never run.
+  ~TaskContext();
+
+  template <typename Callable>
+  Spawned<spawn_result_t<std::decay_t<Callable>>> spawn(Callable&& callable) {
+    using Result = spawn_result_t<std::decay_t<Callable>>;
+    auto state = std::make_shared<SpawnState<Result, std::decay_t<Callable>>>(
+        std::forward<Callable>(callable));
+    Start(state);
+    return Spawned<Result>(std::move(state));
+  }
+
+  // Returns the child's result or rethrows its exception.
+  template <typename T>
+  T wait(Spawned<T>& child) {
+    if (!child.state_) {
+      throw std::logic_error("Spawned task was already waited on");
+    }
+    std::shared_ptr<SpawnResult<T>> state = std::move(child.state_);
+    Forget(state.get());
+    Await(*state);
+    if (state->Error()) {
+      std::rethrow_exception(state->Error());
+    }
+    return state->Take();
+  }
+
+  // Waits for every child not yet waited on; rethrows the first error.
+  void sync();
+
+private:
+  void Start(std::shared_ptr<SpawnStateBase> state);
+  void Forget(const SpawnStateBase* state);
+  void Await(SpawnStateBase& state);
+
+  SpawnTarget target_;
+  std::vector<std::shared_ptr<SpawnStateBase>> children_;
+};
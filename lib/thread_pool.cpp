@@ -0,0 +1,430 @@
+#include "thread_pool.h"
+
+#include <iterator>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+thread_local ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+thread_local int current_node = -1;
+thread_local ThreadPool* current_spare = nullptr;
+
+void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+}
+
+ThreadPool::ThreadPool(size_t workers) {
+  Start(ThreadPoolOptions{.workers = workers});
+}
+
+ThreadPool::ThreadPool(ThreadPoolOptions options) {
+  Start(options);
+}
+
+void ThreadPool::Start(ThreadPoolOptions options) {
+  locality_ = options.locality;
+  // With one CPU a spinning worker only delays the thread that would submit.
+  spin_ns_ = std::thread::hardware_concurrency() > 1 ? options.spin.count() : 0;
+  pending_.store(0, std::memory_order_relaxed);
+  sleepers_.store(0, std::memory_order_relaxed);
+  for (auto& count : level_pending_) {
+    count.value.store(0, std::memory_order_relaxed);
+  }
+  next_worker_.store(0, std::memory_order_relaxed);
+  stopping_ = false;
+
+  CpuTopology topology = CpuTopology::Detect();
+
+  size_t workers = options.workers;
+  if (workers == 0) {
+    workers = std::thread::hardware_concurrency();
+  }
+  if (workers == 0) {
+    workers = 1;
+  }
+
+  node_workers_.resize(topology.NodeCount());
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    auto worker = std::make_unique<Worker>();
+    size_t node = i % topology.NodeCount();
+    const auto& cpus = topology.nodes[node];
+    worker->node = static_cast<int>(node);
+    worker->cpu = cpus[(i / topology.NodeCount()) % cpus.size()];
+    node_workers_[node].push_back(i);
+    workers_.push_back(std::move(worker));
+  }
+
+  while (!node_workers_.empty() && node_workers_.back().empty()) {
+    node_workers_.pop_back();
+  }
+
+  for (size_t i = 0; i < workers; ++i) {
+    bool pin = options.pin_workers;
+    workers_[i]->thread = std::thread([this, i, pin] {
+      if (pin) {
+        PinCurrentThread(workers_[i]->cpu);
+      }
+      WorkerLoop(i);
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stopping_ = true;
+  }
+  idle_cv_.notify_all();
+  spare_cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+  // A spare still running a job may start another before it sees stopping_.
+  while (true) {
+    std::vector<std::thread> spares;
+    {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+      spares.swap(spares_);
+    }
+    if (spares.empty()) {
+      break;
+    }
+    for (auto& spare : spares) {
+      spare.join();
+    }
+  }
+}
+
+int ThreadPool::CurrentNode() {
+  return current_node;
+}
+
+bool ThreadPool::IsWorkerThread() const {
+  return current_pool == this || current_spare == this;
+}
+
+ThreadPool::Blocking::Blocking()
+    : pool_(current_pool ? current_pool : current_spare) {
+  if (pool_) {
+    pool_->BeginBlocking();
+  }
+}
+
+ThreadPool::Blocking::~Blocking() {
+  if (pool_) {
+    pool_->EndBlocking();
+  }
+}
+
+void ThreadPool::BeginBlocking() {
+  std::lock_guard<std::mutex> lock(idle_mutex_);
+  ++blocked_;
+  if (stopping_) {
+    return;
+  }
+  if (spares_.size() < blocked_) {
+    spares_.emplace_back([this] { SpareLoop(); });
+  } else {
+    spare_cv_.notify_one();
+  }
+}
+
+void ThreadPool::EndBlocking() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    --blocked_;
+  }
+  // A serving spare parked on idle_cv_ must see that it is no longer needed.
+  idle_cv_.notify_all();
+}
+
+size_t ThreadPool::LocalSteals() const {
+  size_t steals = 0;
+  for (const auto& worker : workers_) {
+    steals += worker->counters.local_steals.load(std::memory_order_relaxed);
+  }
+  return steals;
+}
+
+size_t ThreadPool::RemoteSteals() const {
+  size_t steals = 0;
+  for (const auto& worker : workers_) {
+    steals += worker->counters.remote_steals.load(std::memory_order_relaxed);
+  }
+  return steals;
+}
+
+std::vector<WorkerStats> ThreadPool::WorkerStatistics() const {
+  std::vector<WorkerStats> stats;
+  stats.reserve(workers_.size());
+  for (const auto& worker : workers_) {
+    const WorkerCounters& counters = worker->counters;
+    stats.push_back(WorkerStats{
+        .jobs = counters.jobs.load(std::memory_order_relaxed),
+        .busy = std::chrono::nanoseconds(counters.busy_ns.load(std::memory_order_relaxed)),
+        .idle = std::chrono::nanoseconds(counters.idle_ns.load(std::memory_order_relaxed)),
+        .local_steals = counters.local_steals.load(std::memory_order_relaxed),
+        .remote_steals = counters.remote_steals.load(std::memory_order_relaxed)});
+  }
+  return stats;
+}
+
+bool ThreadPool::RunOne() {
+  Function<void> job;
+  if (!Take(job)) {
+    return false;
+  }
+  job();
+  return true;
+}
+
+size_t ThreadPool::PickWorker(int node) {
+  if (node >= 0 && static_cast<size_t>(node) < node_workers_.size()) {
+    const auto& candidates = node_workers_[node];
+    if (current_pool == this && workers_[current_worker]->node == node) {
+      return current_worker;
+    }
+    return candidates[next_worker_.fetch_add(1, std::memory_order_relaxed) % candidates.size()];
+  }
+
+  if (locality_ && current_pool == this) {
+    return current_worker;
+  }
+  return next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+}
+
+void ThreadPool::Submit(Function<void> job, JobOptions options) {
+  int level = Level(options.priority);
+
+  Worker& worker = *workers_[PickWorker(options.node)];
+  // Sequentially consistent with the sleeper count: either a parking worker
+  // sees this job, or this thread sees the worker and wakes it.
+  pending_.fetch_add(1, std::memory_order_seq_cst);
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto& queue = worker.queues[level];
+    auto position = queue.end();
+    while (position != queue.begin() && std::prev(position)->deadline > options.deadline) {
+      --position;
+    }
+    queue.insert(position, Job{std::move(job), options.deadline});
+    level_pending_[level].value.fetch_add(1, std::memory_order_release);
+  }
+  Wake();
+}
+
+void ThreadPool::Spawn(Function<void> job, JobOptions options) {
+  if (current_pool != this) {
+    Submit(std::move(job), options);
+    return;
+  }
+  int level = Level(options.priority);
+  Worker& worker = *workers_[current_worker];
+  pending_.fetch_add(1, std::memory_order_seq_cst);
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    // Ahead of any deadline order: a spawned job is part of a running one.
+    worker.queues[level].push_front(Job{std::move(job), options.deadline});
+    level_pending_[level].value.fetch_add(1, std::memory_order_release);
+  }
+  Wake();
+}
+
+void ThreadPool::Wake() {
+  if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+  }
+  idle_cv_.notify_one();
+}
+
+bool ThreadPool::TryPop(size_t index, int level, Function<void>& job) {
+  Worker& worker = *workers_[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  auto& queue = worker.queues[level];
+  if (queue.empty()) {
+    return false;
+  }
+  job = std::move(queue.front().function);
+  queue.pop_front();
+  level_pending_[level].value.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::TrySteal(size_t index, int level, Function<void>& job) {
+  int node = workers_[index]->node;
+
+  for (int pass = 0; pass < 2; ++pass) {
+    bool local = pass == 0;
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+      size_t victim_index = (index + offset) % workers_.size();
+      Worker& victim = *workers_[victim_index];
+      if ((victim.node == node) != local) {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      auto& queue = victim.queues[level];
+      if (queue.empty()) {
+        continue;
+      }
+      job = std::move(queue.back().function);
+      queue.pop_back();
+      level_pending_[level].value.fetch_sub(1, std::memory_order_relaxed);
+
+      WorkerCounters& counters = workers_[index]->counters;
+      StatsAdd(local ? counters.local_steals : counters.remote_steals);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::TryTakeAny(int level, Function<void>& job) {
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    auto& queue = worker->queues[level];
+    if (queue.empty()) {
+      continue;
+    }
+    job = std::move(queue.back().function);
+    queue.pop_back();
+    level_pending_[level].value.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+bool ThreadPool::Take(Function<void>& job) {
+  bool worker = current_pool == this;
+  for (int level = kPriorityLevels - 1; level >= 0; --level) {
+    if (level_pending_[level].value.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    bool found = worker ? TryPop(current_worker, level, job) || TrySteal(current_worker, level, job)
+                        : TryTakeAny(level, job);
+    if (found) {
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::Spin() const {
+  int64_t deadline = StatsNow() + spin_ns_;
+  while (true) {
+    // The clock is read once per batch of pauses, not on every poll.
+    for (int i = 0; i < 64; ++i) {
+      if (pending_.load(std::memory_order_acquire) != 0) {
+        return true;
+      }
+      CpuRelax();
+    }
+    if (StatsNow() >= deadline) {
+      return false;
+    }
+  }
+}
+
+// Takes jobs like a worker without a queue of its own, for as long as more
+// pool threads are blocked than spares serve.
+void ThreadPool::SpareLoop() {
+  current_spare = this;
+  std::unique_lock<std::mutex> lock(idle_mutex_);
+  bool serving = false;
+  while (true) {
+    if (serving && serving_ > blocked_) {
+      --serving_;
+      serving = false;
+    }
+    if (!serving) {
+      spare_cv_.wait(lock, [this] { return stopping_ || serving_ < blocked_; });
+      if (stopping_) {
+        return;
+      }
+      ++serving_;
+      serving = true;
+    }
+
+    lock.unlock();
+    Function<void> job;
+    bool found = Take(job);
+    if (found) {
+      job();
+    }
+    lock.lock();
+    if (found) {
+      continue;
+    }
+
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    idle_cv_.wait(lock, [this] {
+      return stopping_ || serving_ > blocked_ || pending_.load(std::memory_order_seq_cst) != 0;
+    });
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+      --serving_;
+      return;
+    }
+  }
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+  current_node = workers_[index]->node;
+  WorkerCounters& counters = workers_[index]->counters;
+
+  while (true) {
+    Function<void> job;
+    if (Take(job)) {
+      uint64_t jobs = counters.jobs.load(std::memory_order_relaxed);
+      counters.jobs.store(jobs + 1, std::memory_order_relaxed);
+      if (kStatsEnabled && (jobs & (kStatsSampleEvery - 1)) == 0) {
+        int64_t start = StatsNow();
+        job();
+        StatsAdd(counters.busy_ns, (StatsNow() - start) * kStatsSampleEvery);
+      } else {
+        job();
+      }
+      continue;
+    }
+
+    int64_t idle_since = kStatsEnabled ? StatsNow() : 0;
+    if (spin_ns_ > 0 && Spin()) {
+      if constexpr (kStatsEnabled) {
+        StatsAdd(counters.idle_ns, StatsNow() - idle_since);
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    idle_cv_.wait(lock, [this] {
+      return stopping_ || pending_.load(std::memory_order_seq_cst) != 0;
+    });
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    if constexpr (kStatsEnabled) {
+      StatsAdd(counters.idle_ns, StatsNow() - idle_since);
+    }
+    if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
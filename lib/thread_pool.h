@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "stats.h"
+#include "task.h"
+#include "topology.h"
+
+struct JobOptions {
+  int node = -1;
+  // One queue level per value in [0, ThreadPool::kPriorityLevels); values
+  // outside are clamped to the nearest level.
+  int priority = 0;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+struct ThreadPoolOptions {
+  size_t workers = 0;
+  bool pin_workers = false;
+  bool locality = true;
+  // An idle worker polls for new jobs this long before parking, so a job
+  // submitted soon after starts without a futex wake-up. Zero parks at once;
+  // so does a machine with a single CPU.
+  std::chrono::nanoseconds spin{0};
+};
+
+class ThreadPool {
+public:
+  static constexpr int kPriorityLevels = 8;
+
+  explicit ThreadPool(size_t workers);
+  explicit ThreadPool(ThreadPoolOptions options);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  void Submit(Function<void> job, JobOptions options);
+
+  void Submit(Function<void> job, int node = -1) {
+    Submit(std::move(job), JobOptions{.node = node});
+  }
+
+  // From a worker, queues the job at the front of that worker's own queue at
+  // the given priority: the worker takes it next among jobs of that level and
+  // others steal it only after older work. From any other thread this is
+  // Submit.
+  void Spawn(Function<void> job, JobOptions options = {});
+
+  // Runs one queued job on the calling thread. Returns false if none was found.
+  bool RunOne();
+
+  // True on the pool's workers and on the spares that stand in for them.
+  bool IsWorkerThread() const;
+
+  // Held by a pool thread while it parks on something that another pool job
+  // must produce, such as a full channel or an unfinished task. A spare
+  // thread serves the queues until the scope ends, so the job it waits on
+  // can still run. Does nothing on threads the pool does not own.
+  class Blocking {
+  public:
+    Blocking();
+    ~Blocking();
+
+    Blocking(const Blocking&) = delete;
+    Blocking& operator=(const Blocking&) = delete;
+
+  private:
+    ThreadPool* pool_;
+  };
+
+  size_t Size() const { return workers_.size(); }
+
+  size_t NodeCount() const { return node_workers_.size(); }
+
+  size_t LocalSteals() const;
+
+  size_t RemoteSteals() const;
+
+  // Jobs queued and not yet taken by any thread.
+  size_t Pending() const { return pending_.load(std::memory_order_relaxed); }
+
+  // Busy and idle time are only tracked when SCHEDULER_STATS is on.
+  std::vector<WorkerStats> WorkerStatistics() const;
+
+  static int CurrentNode();
+
+private:
+  struct Job {
+    Function<void> function;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // Counters hammered by every worker get a cache line each.
+  struct alignas(64) PaddedCounter {
+    std::atomic<size_t> value;
+  };
+
+  // Written only by the owning worker; kept off the line other threads lock.
+  struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> jobs{0};
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> idle_ns{0};
+    std::atomic<uint64_t> local_steals{0};
+    std::atomic<uint64_t> remote_steals{0};
+  };
+
+  struct alignas(64) Worker {
+    std::array<std::deque<Job>, kPriorityLevels> queues;
+    std::mutex mutex;
+    int node = 0;
+    int cpu = -1;
+    std::thread thread;
+    WorkerCounters counters;
+  };
+
+  static int Level(int priority) {
+    return priority < 0 ? 0 : priority >= kPriorityLevels ? kPriorityLevels - 1 : priority;
+  }
+
+  void Start(ThreadPoolOptions options);
+  void WorkerLoop(size_t index);
+  void SpareLoop();
+  void BeginBlocking();
+  void EndBlocking();
+  size_t PickWorker(int node);
+  void Wake();
+  bool TryPop(size_t index, int level, Function<void>& job);
+  bool TrySteal(size_t index, int level, Function<void>& job);
+  bool TryTakeAny(int level, Function<void>& job);
+  bool Take(Function<void>& job);
+  // Polls for a pending job until the spin budget runs out.
+  bool Spin() const;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::vector<size_t>> node_workers_;
+  bool locality_;
+
+  alignas(64) std::atomic<size_t> pending_;
+  std::array<PaddedCounter, kPriorityLevels> level_pending_;
+  alignas(64) std::atomic<size_t> next_worker_;
+
+  int64_t spin_ns_;
+  // Workers parked or about to park; Submit skips the wake-up when none are.
+  alignas(64) std::atomic<size_t> sleepers_;
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  bool stopping_;
+
+  // Spares are started on demand and kept; under idle_mutex_, one serves per
+  // blocked pool thread and the rest wait on spare_cv_.
+  std::condition_variable spare_cv_;
+  std::vector<std::thread> spares_;
+  size_t blocked_ = 0;
+  size_t serving_ = 0;
+};
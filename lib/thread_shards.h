@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// One Shard per thread that touches the owner, found through a thread-local
+// cache of kSets sets of kWays owners each, so a thread can alternate between
+// dozens of owners without taking the mutex. `owner` must be unique for the
+// process lifetime so a stale cache entry can never match a new owner.
+template <typename Shard>
+class ThreadShards {
+public:
+  explicit ThreadShards(uint32_t owner) : owner_(owner) {}
+
+  ThreadShards(const ThreadShards&) = delete;
+  ThreadShards& operator=(const ThreadShards&) = delete;
+
+  Shard& Local() {
+    Set& set = cache_[owner_ % kSets];
+    for (const Cached& cached : set) {
+      if (cached.owner == owner_) {
+        return *cached.shard;
+      }
+    }
+    return Register(set);
+  }
+
+  template <typename Visitor>
+  void ForEach(Visitor&& visit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [thread, shard] : shards_) {
+      visit(*shard);
+    }
+  }
+
+private:
+  static constexpr size_t kSets = 16;
+  static constexpr size_t kWays = 4;
+
+  struct Cached {
+    uint32_t owner = 0;
+    Shard* shard = nullptr;
+  };
+
+  using Set = std::array<Cached, kWays>;
+
+  // Evicts the set's oldest entry.
+  Shard& Register(Set& set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& shard = shards_[std::this_thread::get_id()];
+    if (!shard) {
+      shard = std::make_unique<Shard>();
+    }
+    std::move_backward(set.begin(), set.end() - 1, set.end());
+    set.front() = Cached{owner_, shard.get()};
+    return *shard;
+  }
+
+  uint32_t owner_;
+  std::mutex mutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<Shard>> shards_;
+
+  static inline thread_local std::array<Set, kSets> cache_;
+};
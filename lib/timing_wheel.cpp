@@ -0,0 +1,227 @@
+#include "timing_wheel.h"
+
+#include <algorithm>
+
+TimingWheel::TimingWheel(uint64_t start_tick) : current_(start_tick), size_(0) {
+  for (auto& level : heads_) {
+    for (auto& head : level) {
+      head = kNil;
+    }
+  }
+}
+
+TimingWheel::TimerId TimingWheel::Schedule(uint64_t expiry_tick, Function<void> callback) {
+  uint32_t index;
+  if (!free_.empty()) {
+    index = free_.back();
+    free_.pop_back();
+  } else {
+    index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+  }
+
+  Node& node = nodes_[index];
+  node.callback = std::move(callback);
+  node.expiry = expiry_tick <= current_ ? current_ + 1 : expiry_tick;
+  node.active = true;
+  Link(index);
+  ++size_;
+
+  return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimingWheel::Cancel(TimerId id) {
+  uint32_t index = static_cast<uint32_t>(id);
+  uint32_t generation = static_cast<uint32_t>(id >> 32);
+  if (index >= nodes_.size()) {
+    return false;
+  }
+
+  Node& node = nodes_[index];
+  if (!node.active || node.generation != generation) {
+    return false;
+  }
+
+  Unlink(index);
+  node.active = false;
+  node.callback = Function<void>();
+  ++node.generation;
+  free_.push_back(index);
+  --size_;
+  return true;
+}
+
+void TimingWheel::Advance(uint64_t tick, std::vector<Function<void>>& fired) {
+  if (size_ == 0 && tick > current_) {
+    current_ = tick;
+    return;
+  }
+
+  while (current_ < tick) {
+    ++current_;
+
+    int highest = 0;
+    for (int level = 1; level < kLevels; ++level) {
+      uint64_t mask = (uint64_t{1} << (kSlotBits * level)) - 1;
+      if ((current_ & mask) != 0) {
+        break;
+      }
+      highest = level;
+    }
+    for (int level = highest; level >= 1; --level) {
+      Cascade(level);
+    }
+
+    uint32_t slot = current_ & (kSlots - 1);
+    uint32_t index = heads_[0][slot];
+    while (index != kNil) {
+      uint32_t next = nodes_[index].next;
+      Node& node = nodes_[index];
+      Unlink(index);
+      fired.push_back(std::move(node.callback));
+      node.callback = Function<void>();
+      node.active = false;
+      ++node.generation;
+      free_.push_back(index);
+      --size_;
+      index = next;
+    }
+
+    if (size_ == 0) {
+      current_ = tick;
+    }
+  }
+}
+
+uint64_t TimingWheel::NextTick() const {
+  if (size_ == 0) {
+    return UINT64_MAX;
+  }
+  uint64_t next = UINT64_MAX;
+  for (int level = 0; level < kLevels; ++level) {
+    int shift = kSlotBits * level;
+    uint64_t position = current_ >> shift;
+    for (uint64_t candidate = position + 1; candidate <= position + kSlots; ++candidate) {
+      if (heads_[level][candidate & (kSlots - 1)] != kNil) {
+        next = std::min(next, candidate << shift);
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void TimingWheel::Cascade(int level) {
+  uint32_t slot = (current_ >> (kSlotBits * level)) & (kSlots - 1);
+  uint32_t index = heads_[level][slot];
+  heads_[level][slot] = kNil;
+
+  while (index != kNil) {
+    uint32_t next = nodes_[index].next;
+    Link(index);
+    index = next;
+  }
+}
+
+void TimingWheel::Link(uint32_t index) {
+  Node& node = nodes_[index];
+  uint64_t delta = node.expiry - current_;
+
+  int level = 0;
+  while (level < kLevels - 1 && delta >= (uint64_t{1} << (kSlotBits * (level + 1)))) {
+    ++level;
+  }
+
+  node.level = static_cast<uint16_t>(level);
+  node.slot = static_cast<uint16_t>((node.expiry >> (kSlotBits * level)) & (kSlots - 1));
+  node.prev = kNil;
+  node.next = heads_[level][node.slot];
+  if (node.next != kNil) {
+    nodes_[node.next].prev = index;
+  }
+  heads_[level][node.slot] = index;
+}
+
+void TimingWheel::Unlink(uint32_t index) {
+  Node& node = nodes_[index];
+  if (node.prev != kNil) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    heads_[node.level][node.slot] = node.next;
+  }
+  if (node.next != kNil) {
+    nodes_[node.next].prev = node.prev;
+  }
+  node.prev = kNil;
+  node.next = kNil;
+}
+
+TimerService::TimerService()
+    : start_(Clock::now()), wheel_(0), stopping_(false), thread_([this] { Loop(); }) {}
+
+TimerService::~TimerService() {
+  Stop();
+}
+
+uint64_t TimerService::TickOf(Clock::time_point time) const {
+  if (time <= start_) {
+    return 0;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - start_).count();
+  return static_cast<uint64_t>((elapsed + 999) / 1000);
+}
+
+TimerService::TimerId TimerService::Schedule(Clock::time_point due, Function<void> callback) {
+  TimerId id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = wheel_.Schedule(TickOf(due), std::move(callback));
+  }
+  cv_.notify_one();
+  return id;
+}
+
+bool TimerService::Cancel(TimerId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return wheel_.Cancel(id);
+}
+
+void TimerService::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void TimerService::Loop() {
+  std::vector<Function<void>> fired;
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (!stopping_) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start_);
+    wheel_.Advance(static_cast<uint64_t>(elapsed.count()), fired);
+
+    if (!fired.empty()) {
+      lock.unlock();
+      for (auto& callback : fired) {
+        callback();
+      }
+      fired.clear();
+      lock.lock();
+      continue;
+    }
+
+    // Schedule notifies, so a sooner timer cuts the sleep short.
+    uint64_t next = wheel_.NextTick();
+    if (next == UINT64_MAX) {
+      cv_.wait(lock);
+    } else {
+      cv_.wait_until(lock, start_ + std::chrono::milliseconds(next));
+    }
+  }
+}
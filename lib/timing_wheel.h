@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "task.h"
+
+class TimingWheel {
+public:
+  using TimerId = uint64_t;
+
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotBits = 8;
+  static constexpr uint32_t kSlots = 1u << kSlotBits;
+
+  explicit TimingWheel(uint64_t start_tick = 0);
+
+  TimerId Schedule(uint64_t expiry_tick, Function<void> callback);
+
+  bool Cancel(TimerId id);
+
+  void Advance(uint64_t tick, std::vector<Function<void>>& fired);
+
+  // The first tick at which Advance has work: a level-0 slot expires or a
+  // higher slot cascades. No timer fires before it. UINT64_MAX when empty.
+  uint64_t NextTick() const;
+
+  size_t Size() const { return size_; }
+
+  uint64_t CurrentTick() const { return current_; }
+
+private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Node {
+    Function<void> callback;
+    uint64_t expiry = 0;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t generation = 0;
+    uint16_t level = 0;
+    uint16_t slot = 0;
+    bool active = false;
+  };
+
+  void Link(uint32_t index);
+  void Unlink(uint32_t index);
+  void Cascade(int level);
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_;
+  uint32_t heads_[kLevels][kSlots];
+  uint64_t current_;
+  size_t size_;
+};
+
+class TimerService {
+public:
+  using Clock = std::chrono::steady_clock;
+  using TimerId = TimingWheel::TimerId;
+
+  TimerService();
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  ~TimerService();
+
+  TimerId Schedule(Clock::time_point due, Function<void> callback);
+
+  bool Cancel(TimerId id);
+
+  void Stop();
+
+private:
+  uint64_t TickOf(Clock::time_point time) const;
+  void Loop();
+
+  Clock::time_point start_;
+  TimingWheel wheel_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_;
+  std::thread thread_;
+};
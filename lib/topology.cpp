@@ -0,0 +1,93 @@
+#include "topology.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+bool IsAllowed(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return true;
+  }
+  return CPU_ISSET(cpu, &set);
+#else
+  (void)cpu;
+  return true;
+#endif
+}
+
+}
+
+CpuTopology CpuTopology::Detect() {
+  CpuTopology topology;
+
+  for (int node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file) {
+      break;
+    }
+    std::string list;
+    std::getline(file, list);
+
+    std::vector<int> cpus;
+    for (int cpu : ParseCpuList(list)) {
+      if (IsAllowed(cpu)) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      topology.nodes.push_back(std::move(cpus));
+    }
+  }
+
+  if (topology.nodes.empty()) {
+    int count = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < (count == 0 ? 1 : count); ++cpu) {
+      cpus.push_back(cpu);
+    }
+    topology.nodes.push_back(std::move(cpus));
+  }
+
+  return topology;
+}
+
+bool PinCurrentThread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
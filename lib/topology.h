@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct CpuTopology {
+  std::vector<std::vector<int>> nodes;
+
+  size_t NodeCount() const { return nodes.size(); }
+
+  static CpuTopology Detect();
+};
+
+bool PinCurrentThread(int cpu);
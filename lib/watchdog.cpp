@@ -0,0 +1,108 @@
+#include "watchdog.h"
+
+#include <algorithm>
+
+void Watchdog::Scope::Enter(uint32_t task, TaskBase::RunFunction site) {
+  slot_ = &watchdog_->slots_.Local();
+  outer_task_ = slot_->task.load(std::memory_order_relaxed);
+  outer_since_ = slot_->since.load(std::memory_order_relaxed);
+  outer_site_ = slot_->site.load(std::memory_order_relaxed);
+  Publish(task, StatsNow(), site);
+}
+
+void Watchdog::Scope::Leave() {
+  if (watchdog_->options_.factor > 0) {
+    watchdog_->Learn(slot_->site.load(std::memory_order_relaxed),
+                     StatsNow() - slot_->since.load(std::memory_order_relaxed));
+  }
+  Publish(outer_task_, outer_since_, outer_site_);
+}
+
+// The task id goes idle first and is stored last, so a reader that sees the
+// same id before and after reading the rest has a consistent snapshot.
+void Watchdog::Scope::Publish(uint32_t task, int64_t since, TaskBase::RunFunction site) {
+  slot_->task.store(kIdle, std::memory_order_release);
+  slot_->since.store(since, std::memory_order_release);
+  slot_->site.store(site, std::memory_order_release);
+  slot_->task.store(task, std::memory_order_release);
+}
+
+std::chrono::steady_clock::duration Watchdog::Interval() const {
+  if (options_.threshold.count() <= 0) {
+    return std::chrono::milliseconds(1);
+  }
+  return std::clamp<std::chrono::steady_clock::duration>(
+      options_.threshold / 4, std::chrono::milliseconds(1), std::chrono::milliseconds(100));
+}
+
+void Watchdog::Learn(TaskBase::RunFunction site, int64_t nanoseconds) {
+  Site& entry = sites_[SiteIndex(site)];
+  if (entry.site.load(std::memory_order_relaxed) != site) {
+    entry.count.store(1, std::memory_order_relaxed);
+    entry.mean_ns.store(nanoseconds, std::memory_order_relaxed);
+    entry.site.store(site, std::memory_order_release);
+    return;
+  }
+  uint64_t count = entry.count.load(std::memory_order_relaxed) + 1;
+  int64_t mean = entry.mean_ns.load(std::memory_order_relaxed);
+  entry.mean_ns.store(mean + (nanoseconds - mean) / static_cast<int64_t>(count),
+                      std::memory_order_relaxed);
+  entry.count.store(count, std::memory_order_relaxed);
+}
+
+int64_t Watchdog::LearnedLimit(TaskBase::RunFunction site) const {
+  const Site& entry = sites_[SiteIndex(site)];
+  if (entry.site.load(std::memory_order_acquire) != site ||
+      entry.count.load(std::memory_order_relaxed) < options_.min_samples) {
+    return INT64_MAX;
+  }
+  return static_cast<int64_t>(
+      static_cast<double>(entry.mean_ns.load(std::memory_order_relaxed)) * options_.factor);
+}
+
+std::vector<Watchdog::Candidate> Watchdog::Scan(int64_t now) {
+  std::vector<Candidate> candidates;
+  int64_t fixed = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.threshold).count();
+
+  slots_.ForEach([&](RunningSlot& slot) {
+    uint32_t task = slot.task.load(std::memory_order_acquire);
+    if (task == kIdle) {
+      return;
+    }
+    int64_t since = slot.since.load(std::memory_order_acquire);
+    TaskBase::RunFunction site = slot.site.load(std::memory_order_acquire);
+    if (slot.task.load(std::memory_order_acquire) != task || slot.reported == since) {
+      return;
+    }
+
+    int64_t limit = fixed > 0 ? fixed : INT64_MAX;
+    if (options_.factor > 0) {
+      limit = std::min(limit, LearnedLimit(site));
+    }
+
+    int64_t elapsed = now - since;
+    if (elapsed > limit) {
+      slot.reported = since;
+      candidates.push_back(Candidate{task, elapsed, limit});
+    }
+  });
+  return candidates;
+}
+
+void Watchdog::Report(StragglerReport report) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reports_.size() == kMaxReports) {
+      reports_.erase(reports_.begin());
+    }
+    reports_.push_back(report);
+  }
+  if (options_.on_straggler) {
+    options_.on_straggler(report);
+  }
+}
+
+std::vector<StragglerReport> Watchdog::Reports() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reports_;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "stats.h"
+#include "task.h"
+#include "thread_shards.h"
+
+struct StragglerReport {
+  uint32_t task_id = 0;
+  // Longest chain of dependencies leading to the task.
+  size_t depth = 0;
+  std::chrono::nanoseconds elapsed{0};
+  // The limit the task crossed: the fixed threshold or the learned one.
+  std::chrono::nanoseconds limit{0};
+  // Direct dependents that have not finished, and the number of unfinished
+  // tasks anywhere downstream.
+  std::vector<uint32_t> waiting;
+  size_t blocked = 0;
+};
+
+struct WatchdogOptions {
+  // Flag tasks running longer than this; zero disables the fixed limit.
+  std::chrono::steady_clock::duration threshold{};
+  // Flag tasks running longer than `factor` times the mean run time learned
+  // for the same callable, once `min_samples` runs have been seen.
+  double factor = 0;
+  size_t min_samples = 8;
+  // Called on the watchdog thread once per straggling run.
+  Function<void(const StragglerReport&)> on_straggler;
+
+  bool Enabled() const { return threshold.count() > 0 || factor > 0; }
+};
+
+// Each running thread publishes what it runs in a slot of its own and the
+// watchdog polls the slots, so a watched task costs two clock reads and a few
+// relaxed stores. Learning a limit adds an update of the callable's entry in
+// a lock-free table, which like RunCosts may drop a sample under a race.
+class Watchdog {
+public:
+  static constexpr uint32_t kIdle = UINT32_MAX;
+  static constexpr size_t kMaxReports = 1024;
+
+  struct Candidate {
+    uint32_t task_id;
+    int64_t elapsed;
+    int64_t limit;
+  };
+
+  struct RunningSlot {
+    std::atomic<uint32_t> task{kIdle};
+    std::atomic<int64_t> since{0};
+    std::atomic<TaskBase::RunFunction> site{nullptr};
+    // Start of the last run reported; only the watchdog thread touches it.
+    int64_t reported = 0;
+  };
+
+  // Publishes `task` as running on this thread until the scope ends. A
+  // nested run, as when a task helps while it waits, restores the outer one.
+  class Scope {
+  public:
+    Scope(Watchdog* watchdog, uint32_t task, TaskBase::RunFunction site)
+        : watchdog_(watchdog) {
+      if (watchdog_ != nullptr) {
+        Enter(task, site);
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope() {
+      if (watchdog_ != nullptr) {
+        Leave();
+      }
+    }
+
+  private:
+    void Enter(uint32_t task, TaskBase::RunFunction site);
+    void Leave();
+    void Publish(uint32_t task, int64_t since, TaskBase::RunFunction site);
+
+    Watchdog* watchdog_;
+    RunningSlot* slot_ = nullptr;
+    uint32_t outer_task_ = kIdle;
+    int64_t outer_since_ = 0;
+    TaskBase::RunFunction outer_site_ = nullptr;
+  };
+
+  Watchdog(uint32_t owner, WatchdogOptions options)
+      : options_(std::move(options)), slots_(owner) {}
+
+  std::chrono::steady_clock::duration Interval() const;
+
+  // Running tasks over their limit that have not been reported yet.
+  std::vector<Candidate> Scan(int64_t now);
+
+  // Keeps the report (the newest kMaxReports) and calls on_straggler.
+  void Report(StragglerReport report);
+
+  std::vector<StragglerReport> Reports();
+
+private:
+  static constexpr size_t kSites = 256;  // SiteIndex() yields 8 bits.
+
+  // Direct-mapped; a callable that takes over an entry starts learning again.
+  struct alignas(32) Site {
+    std::atomic<TaskBase::RunFunction> site{nullptr};
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> mean_ns{0};
+  };
+
+  static size_t SiteIndex(TaskBase::RunFunction site) {
+    uint64_t bits = reinterpret_cast<uintptr_t>(site);
+    return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ull) >> 56);
+  }
+
+  void Learn(TaskBase::RunFunction site, int64_t nanoseconds);
+
+  // The learned limit for `site`, or INT64_MAX before min_samples runs.
+  int64_t LearnedLimit(TaskBase::RunFunction site) const;
+
+  WatchdogOptions options_;
+  ThreadShards<RunningSlot> slots_;
+  std::array<Site, kSites> sites_;
+  std::mutex mutex_;
+  std::vector<StragglerReport> reports_;
+};
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+TEST(AllocationTest, ReexecutionDoesNotAllocate) {
+    size_t initial = allocations.load();
+    TTaskScheduler scheduler;
+
+    int runs = 0;
+    auto root = scheduler.add([&runs]() {
+        ++runs;
+        return 1;
+    });
+    auto left = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(root));
+    auto right = scheduler.add([](int x) { return x * 3; }, scheduler.getFutureResult<int>(root));
+    auto join = scheduler.add([](int l, int r) { return l + r; },
+                              scheduler.getFutureResult<int>(left),
+                              scheduler.getFutureResult<int>(right));
+    auto previous = join;
+    for (int i = 0; i < 100; ++i) {
+        previous = scheduler.add([](int x) { return x + 1; },
+                                 scheduler.getFutureResult<int>(previous));
+    }
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(previous), 105);
+    EXPECT_GT(allocations.load(), initial);
+
+    for (int round = 0; round < 5; ++round) {
+        size_t before = allocations.load();
+        scheduler.reset();
+        scheduler.executeAll();
+        size_t after = allocations.load();
+
+        EXPECT_EQ(after - before, 0);
+    }
+    EXPECT_EQ(runs, 6);
+    EXPECT_EQ(scheduler.getResult<int>(previous), 105);
+}
+
+TEST(AllocationTest, NewEdgeInvalidatesCachedOrder) {
+    TTaskScheduler scheduler;
+
+    int value = 0;
+    auto first = scheduler.add([&value]() { return value; });
+    auto second = scheduler.add([&value]() { return ++value; });
+    scheduler.executeAll();
+
+    scheduler.reset();
+    first->AddDependendTask(second);
+    value = 10;
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(first), 11);
+}
+
+TEST(AllocationTest, EagerResetRunsGraphAgain) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<int> runs{0};
+    auto root = scheduler.add([&runs]() { return ++runs; });
+    auto child = scheduler.add([](int x) { return x * 10; }, scheduler.getFutureResult<int>(root));
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(child), 10);
+
+    scheduler.reset();
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(child), 20);
+}
+
+TEST(AllocationTest, OtherSchedulersEdgesKeepCachedOrder) {
+    TTaskScheduler first;
+    TTaskScheduler second;
+
+    auto root = first.add([]() { return 1; });
+    auto leaf = first.add([](int x) { return x + 1; }, first.getFutureResult<int>(root));
+    auto tail = second.add([]() { return 1; });
+    first.executeAll();
+    second.executeAll();
+
+    for (int round = 0; round < 5; ++round) {
+        tail = second.add([](int x) { return x + 1; }, second.getFutureResult<int>(tail));
+        root = first.add([](int x) { return x; }, first.getFutureResult<int>(leaf));
+
+        size_t before = allocations.load();
+        second.reset();
+        second.executeAll();
+        EXPECT_EQ(allocations.load() - before, 0);
+
+        before = allocations.load();
+        first.reset();
+        first.executeAll();
+        EXPECT_EQ(allocations.load() - before, 0);
+    }
+    EXPECT_EQ(second.getResult<int>(tail), 6);
+
+    if (kStatsEnabled) {
+        EXPECT_EQ(first.stats().topsorts, 1);
+        EXPECT_EQ(second.stats().topsorts, 1);
+    }
+}
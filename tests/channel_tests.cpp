@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(ChannelTest, PushPopPreservesOrder) {
+    Channel<int> channel(4);
+    EXPECT_EQ(channel.Capacity(), 4);
+
+    for (int i = 0; i < 4; ++i) {
+        channel.Push(i);
+    }
+    int extra = 4;
+    EXPECT_FALSE(channel.TryPush(extra));
+
+    channel.Close();
+    int value = 0;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(channel.Pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(channel.Pop(value));
+}
+
+TEST(ChannelTest, MultipleProducersAndConsumers) {
+    Channel<int> channel(8);
+    const int perProducer = 1000;
+    std::atomic<long long> sum{0};
+    std::atomic<int> producersLeft{2};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 1; i <= perProducer; ++i) {
+                channel.Push(i);
+            }
+            if (--producersLeft == 0) {
+                channel.Close();
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&] {
+            int value = 0;
+            while (channel.Pop(value)) {
+                sum += value;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(sum.load(), 2LL * perProducer * (perProducer + 1) / 2);
+}
+
+TEST(StreamTest, ParseTransformAggregate) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 3});
+
+    auto lines = scheduler.addStream<std::string>([](Channel<std::string>& out) {
+        for (int i = 1; i <= 100; ++i) {
+            out.Push(std::to_string(i));
+        }
+    }, 8);
+
+    auto numbers = scheduler.addStream<int>([](Channel<std::string>& in, Channel<int>& out) {
+        std::string line;
+        while (in.Pop(line)) {
+            out.Push(std::stoi(line));
+        }
+    }, lines, 8);
+
+    auto total = scheduler.add([](Channel<int>& in) {
+        int sum = 0;
+        int value = 0;
+        while (in.Pop(value)) {
+            sum += value;
+        }
+        return sum;
+    }, numbers);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(total), 5050);
+}
+
+TEST(StreamTest, ConsumerStartsBeforeProducerFinishes) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> firstConsumed{false};
+    auto stream = scheduler.addStream<int>([&firstConsumed](Channel<int>& out) {
+        out.Push(1);
+        while (!firstConsumed.load()) {
+            std::this_thread::yield();
+        }
+        out.Push(2);
+    }, 2);
+
+    auto consumer = scheduler.add([&firstConsumed](Channel<int>& in) {
+        int value = 0;
+        int sum = 0;
+        while (in.Pop(value)) {
+            sum += value;
+            firstConsumed = true;
+        }
+        return sum;
+    }, stream);
+
+    EXPECT_EQ(scheduler.getResult<int>(consumer), 3);
+}
+
+TEST(StreamTest, ProducerErrorReachesConsumer) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto stream = scheduler.addStream<int>([](Channel<int>& out) {
+        out.Push(1);
+        throw std::runtime_error("parse error");
+    });
+
+    auto consumer = scheduler.add([](Channel<int>& in) {
+        int value = 0;
+        int count = 0;
+        while (in.Pop(value)) {
+            ++count;
+        }
+        return count;
+    }, stream);
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+    EXPECT_THROW(scheduler.getResult<int>(consumer), std::runtime_error);
+}
+
+TEST(StreamTest, RequiresEagerScheduler) {
+    TTaskScheduler scheduler;
+    EXPECT_THROW(scheduler.addStream<int>([](Channel<int>&) {}), std::logic_error);
+}
+
+TEST(StreamTest, SingleWorkerRunsProducerAndConsumer) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    auto stream = scheduler.addStream<int>([](Channel<int>& out) {
+        for (int i = 1; i <= 100; ++i) {
+            out.Push(i);
+        }
+    }, 4);
+
+    auto total = scheduler.add([](Channel<int>& in) {
+        int sum = 0;
+        int value = 0;
+        while (in.Pop(value)) {
+            sum += value;
+        }
+        return sum;
+    }, stream);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(total), 5050);
+}
+
+TEST(StreamTest, SingleWorkerRunsMoreStagesThanWorkers) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    auto numbers = scheduler.addStream<int>([](Channel<int>& out) {
+        for (int i = 1; i <= 1000; ++i) {
+            out.Push(i);
+        }
+    }, 2);
+
+    auto doubled = scheduler.addStream<int>([](Channel<int>& in, Channel<int>& out) {
+        int value = 0;
+        while (in.Pop(value)) {
+            out.Push(value * 2);
+        }
+    }, numbers, 2);
+
+    auto total = scheduler.add([](Channel<int>& in) {
+        long long sum = 0;
+        int value = 0;
+        while (in.Pop(value)) {
+            sum += value;
+        }
+        return sum;
+    }, doubled);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<long long>(total), 1000LL * 1001);
+}
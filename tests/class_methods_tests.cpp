@@ -1,5 +1,6 @@
 #include "../lib/scheduler.h"
 #include <gtest/gtest.h>
+#include <cmath>
 #include <string>
 
 
@@ -5,6 +5,7 @@
 #include <string>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 struct TestClass {
     int multiply(int x) const { return x * factor; }
@@ -302,4 +303,244 @@ TEST(dependecyTest, ComplexDependency) {
     EXPECT_EQ(scheduler.getResult(id2), 4);
     EXPECT_EQ(scheduler.getResult(id3), 2);
     EXPECT_EQ(scheduler.getResult(id4), std::make_pair(4,2));
-}
\ No newline at end of file
+}
+TEST(dependecyTest, AddDependencyReordersExecution) {
+    TTaskScheduler scheduler;
+
+    std::vector<int> order;
+    auto first = scheduler.add([&order]() { order.push_back(1); return 1; });
+    auto second = scheduler.add([&order]() { order.push_back(2); return 2; });
+    auto third = scheduler.add([&order](int x) { order.push_back(3); return x; },
+                               scheduler.getFutureResult<int>(second));
+
+    scheduler.addDependency(first, third);
+    scheduler.executeAll();
+
+    EXPECT_EQ(order, std::vector<int>({2, 3, 1}));
+}
+
+TEST(dependecyTest, AddDependencyRejectsCycleImmediately) {
+    TTaskScheduler scheduler;
+
+    auto task1 = scheduler.add([]() { return 1; });
+    auto task2 = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(task1));
+    auto task3 = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(task2));
+
+    EXPECT_THROW(scheduler.addDependency(task1, task3), std::runtime_error);
+    EXPECT_THROW(scheduler.addDependency(task2, task2), std::runtime_error);
+    EXPECT_EQ(task1->GetDependecies().size(), 0);
+
+    EXPECT_NO_THROW(scheduler.executeAll());
+    EXPECT_EQ(scheduler.getResult<int>(task3), 3);
+}
+
+TEST(dependecyTest, IncrementalOrderMatchesRandomEdges) {
+    TTaskScheduler scheduler;
+
+    const int count = 200;
+    std::vector<int> position(count, -1);
+    int next = 0;
+    std::vector<std::shared_ptr<Task<int>>> tasks;
+    for (int i = 0; i < count; ++i) {
+        tasks.push_back(scheduler.add([&position, &next, i]() {
+            position[i] = next++;
+            return i;
+        }));
+    }
+    scheduler.executeAll();
+    scheduler.reset();
+
+    std::vector<std::pair<int, int>> edges;
+    unsigned seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<int>((seed >> 16) % count);
+    };
+    int rejected = 0;
+    for (int i = 0; i < 2000; ++i) {
+        int task = random();
+        int dependency = random();
+        try {
+            scheduler.addDependency(tasks[task], tasks[dependency]);
+            edges.emplace_back(task, dependency);
+        } catch (const std::runtime_error&) {
+            ++rejected;
+        }
+    }
+    EXPECT_GT(rejected, 0);
+
+    next = 0;
+    scheduler.executeAll();
+    for (auto [task, dependency] : edges) {
+        EXPECT_LT(position[dependency], position[task]);
+    }
+}
+
+TEST(dependecyTest, ExecuteAllRunsOnlyNewTasks) {
+    TTaskScheduler scheduler;
+
+    int runs = 0;
+    auto root = scheduler.add([&runs]() { ++runs; return 1; });
+    scheduler.executeAll();
+
+    auto child = scheduler.add([&runs](int x) { ++runs; return x + 1; },
+                               scheduler.getFutureResult<int>(root));
+    scheduler.executeAll();
+
+    EXPECT_EQ(runs, 2);
+    EXPECT_EQ(scheduler.getResult<int>(child), 2);
+}
+
+TEST(dependecyTest, ReduceGraphRemovesRedundantEdges) {
+    TTaskScheduler scheduler;
+
+    auto a = scheduler.add([]() { return 1; });
+    auto futureA = scheduler.getFutureResult<int>(a);
+    auto b = scheduler.add([](int x, int y) { return x + y; }, futureA, futureA);
+    auto c = scheduler.add([](int x, int y) { return x * y; },
+                           scheduler.getFutureResult<int>(b), futureA);
+    auto d = scheduler.add([](int x, int y) { return x - y; },
+                           scheduler.getFutureResult<int>(c), futureA);
+
+    GraphReduction report = scheduler.reduceGraph();
+    EXPECT_EQ(report.duplicate_edges, 1);
+    EXPECT_EQ(report.transitive_edges, 2);
+    EXPECT_EQ(report.Removed(), 3);
+    EXPECT_EQ(scheduler.reduceGraph().Removed(), 0);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(d), 1);
+}
+
+TEST(dependecyTest, ReducedGraphKeepsOrderingSound) {
+    TTaskScheduler scheduler;
+
+    const int count = 300;
+    std::vector<int> position(count, -1);
+    int next = 0;
+    std::vector<std::shared_ptr<Task<int>>> tasks;
+    std::vector<std::pair<int, int>> edges;
+    unsigned seed = 777;
+    auto random = [&seed](int bound) {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<int>((seed >> 16) % bound);
+    };
+
+    for (int i = 0; i < count; ++i) {
+        auto body = [&position, &next, i](int) {
+            position[i] = next++;
+            return i;
+        };
+        if (i == 0) {
+            tasks.push_back(scheduler.add([&position, &next]() {
+                position[0] = next++;
+                return 0;
+            }));
+            continue;
+        }
+        int parent1 = random(i);
+        int parent2 = random(i);
+        tasks.push_back(scheduler.add([body](int x, int) { return body(x); },
+                                      scheduler.getFutureResult<int>(tasks[parent1]),
+                                      scheduler.getFutureResult<int>(tasks[parent2])));
+        edges.emplace_back(i, parent1);
+        edges.emplace_back(i, parent2);
+    }
+
+    GraphReduction report = scheduler.reduceGraph();
+    EXPECT_GT(report.Removed(), 0);
+
+    for (int i = 0; i < 200; ++i) {
+        int task = random(count);
+        int dependency = random(count);
+        try {
+            scheduler.addDependency(tasks[task], tasks[dependency]);
+            edges.emplace_back(task, dependency);
+        } catch (const std::runtime_error&) {
+        }
+    }
+
+    scheduler.executeAll();
+    for (auto [task, dependency] : edges) {
+        EXPECT_LT(position[dependency], position[task]);
+    }
+}
+
+TEST(dependecyTest, ReducedGraphResortsOverReducedEdges) {
+    TTaskScheduler scheduler;
+
+    const int count = 100;
+    std::vector<int> position(count + 1, -1);
+    int next = 0;
+    std::vector<std::shared_ptr<Task<int>>> tasks;
+    std::vector<std::pair<int, int>> edges;
+    tasks.push_back(scheduler.add([&position, &next]() {
+        position[0] = next++;
+        return 0;
+    }));
+    for (int i = 1; i < count; ++i) {
+        int parent = i / 2;
+        int grandparent = parent / 2;
+        tasks.push_back(scheduler.add([&position, &next, i](int x, int) {
+            position[i] = next++;
+            return x + 1;
+        }, scheduler.getFutureResult<int>(tasks[parent]),
+           scheduler.getFutureResult<int>(tasks[grandparent])));
+        edges.emplace_back(i, parent);
+        edges.emplace_back(i, grandparent);
+    }
+    EXPECT_GT(scheduler.reduceGraph().transitive_edges, 0);
+
+    // A priority forces a full re-sort, now over the reduced edges.
+    auto urgent = scheduler.with(TaskOptions{.priority = 5}).add([&position, &next](int x) {
+        position[count] = next++;
+        return x;
+    }, scheduler.getFutureResult<int>(tasks[count - 1]));
+    edges.emplace_back(count, count - 1);
+    scheduler.executeAll();
+
+    for (auto [task, dependency] : edges) {
+        EXPECT_LT(position[dependency], position[task]);
+    }
+    EXPECT_EQ(next, count + 1);
+    EXPECT_EQ(scheduler.getResult<int>(urgent), scheduler.getResult<int>(tasks[count - 1]));
+}
+
+TEST(dependecyTest, ReducedEagerGraphRunsAfterReset) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4});
+
+    auto a = scheduler.add([]() { return 2; });
+    auto futureA = scheduler.getFutureResult<int>(a);
+    auto b = scheduler.add([](int x) { return x + 1; }, futureA);
+    auto c = scheduler.add([](int x, int y) { return x * y; },
+                           scheduler.getFutureResult<int>(b), futureA);
+
+    EXPECT_EQ(scheduler.reduceGraph().transitive_edges, 1);
+    scheduler.reset();
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(c), 6);
+}
+
+TEST(dependecyTest, InterleavedSchedulersKeepIncrementalOrder) {
+    TTaskScheduler first;
+    TTaskScheduler second;
+
+    auto left = first.add([]() { return 0; });
+    auto right = second.add([]() { return 0; });
+    first.executeAll();
+    second.executeAll();
+
+    for (int i = 0; i < 20; ++i) {
+        left = first.add([](int x) { return x + 1; }, first.getFutureResult<int>(left));
+        right = second.add([](int x) { return x + 2; }, second.getFutureResult<int>(right));
+        first.executeAll();
+        second.executeAll();
+    }
+
+    EXPECT_EQ(first.getResult<int>(left), 20);
+    EXPECT_EQ(second.getResult<int>(right), 40);
+    if (kStatsEnabled) {
+        EXPECT_EQ(first.stats().topsorts, 1);
+        EXPECT_EQ(second.stats().topsorts, 1);
+    }
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+bool WaitUntil(const std::atomic<bool>& flag) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag.load()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+}
+
+TEST(EagerTest, IndependentTaskStartsBeforeExecuteAll) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> started{false};
+    auto task = scheduler.add([&started]() {
+        started = true;
+        return 1;
+    });
+
+    EXPECT_TRUE(WaitUntil(started));
+
+    scheduler.executeAll();
+    EXPECT_TRUE(task->IsExecuted());
+    EXPECT_EQ(scheduler.getResult<int>(task), 1);
+}
+
+TEST(EagerTest, DependentWaitsForInputs) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> release{false};
+    auto task1 = scheduler.add([&release]() {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        return 20;
+    });
+
+    auto task2 = scheduler.add([](int x, int y) { return x + y; },
+                               scheduler.getFutureResult<int>(task1), 22);
+
+    EXPECT_FALSE(task2->IsExecuted());
+    release = true;
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(task2), 42);
+}
+
+TEST(EagerTest, QuadraticEquation) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true});
+
+    float a = 1;
+    float b = -2;
+    float c = 0;
+
+    auto id1 = scheduler.add([](float a, float c) { return -4 * a * c; }, a, c);
+    auto id2 = scheduler.add([](float b, float v) { return b * b + v; }, b,
+                             scheduler.getFutureResult<float>(id1));
+    auto id3 = scheduler.add([](float b, float d) { return -b + std::sqrt(d); }, b,
+                             scheduler.getFutureResult<float>(id2));
+    auto id4 = scheduler.add([](float b, float d) { return -b - std::sqrt(d); }, b,
+                             scheduler.getFutureResult<float>(id2));
+    auto id5 = scheduler.add([](float a, float v) { return v / (2 * a); }, a,
+                             scheduler.getFutureResult<float>(id3));
+    auto id6 = scheduler.add([](float a, float v) { return v / (2 * a); }, a,
+                             scheduler.getFutureResult<float>(id4));
+
+    scheduler.executeAll();
+
+    EXPECT_FLOAT_EQ(scheduler.getResult<float>(id5), 2.0f);
+    EXPECT_FLOAT_EQ(scheduler.getResult<float>(id6), 0.0f);
+}
+
+TEST(EagerTest, GetResultWaitsForCompletion) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    auto task1 = scheduler.add([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return 5;
+    });
+    auto task2 = scheduler.add([](int x) { return x * 3; },
+                               scheduler.getFutureResult<int>(task1));
+
+    EXPECT_EQ(scheduler.getResult<int>(task2), 15);
+}
+
+TEST(EagerTest, ExceptionSkipsDependents) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> dependentRan{false};
+    auto task1 = scheduler.add([]() -> int {
+        throw std::runtime_error("Task failure");
+    });
+    auto task2 = scheduler.add([&dependentRan](int x) {
+        dependentRan = true;
+        return x;
+    }, scheduler.getFutureResult<int>(task1));
+    auto task3 = scheduler.add([]() { return 3; });
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+    EXPECT_THROW(scheduler.getResult<int>(task2), std::runtime_error);
+    EXPECT_FALSE(dependentRan);
+    EXPECT_EQ(scheduler.getResult<int>(task3), 3);
+}
+
+TEST(EagerTest, TasksAddedAfterExecuteAll) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true});
+
+    auto task1 = scheduler.add([]() { return 1; });
+    scheduler.executeAll();
+
+    auto task2 = scheduler.add([](int x) { return x + 1; },
+                               scheduler.getFutureResult<int>(task1));
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(task2), 2);
+}
+
+TEST(EagerTest, RejectsForeignFutures) {
+    TTaskScheduler other;
+    auto foreign = other.add([] { return 1; });
+    std::shared_ptr<Task<int>> unregistered = std::make_shared<Task<int>>([] { return 2; });
+
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+    EXPECT_THROW(scheduler.add([](int x) { return x; }, other.getFutureResult<int>(foreign)),
+                 std::invalid_argument);
+    EXPECT_THROW(scheduler.add([](int x) { return x; }, FutureResult<int>(unregistered)),
+                 std::invalid_argument);
+
+    auto own = scheduler.add([] { return 3; });
+    auto reader = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(own));
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(reader), 4);
+    EXPECT_FALSE(foreign->IsExecuted());
+}
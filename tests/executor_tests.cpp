@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Runs every job on a fresh thread and counts them.
+class ThreadPerJobExecutor : public Executor {
+public:
+    ~ThreadPerJobExecutor() override {
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void Submit(Function<void> job, JobOptions) override {
+        ++submitted;
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.emplace_back([job = std::move(job)]() mutable { job(); });
+    }
+
+    std::atomic<int> submitted{0};
+
+private:
+    std::mutex mutex_;
+    std::vector<std::thread> threads_;
+};
+
+}
+
+TEST(ExecutorTest, IoTaskFeedsCpuTask) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    auto io = std::make_shared<BlockingExecutor>();
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .pool = pool});
+
+    auto read = scheduler.on(io).add([&pool] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return pool->IsWorkerThread() ? -1 : 21;
+    });
+    auto parse = scheduler.add([&pool](int x) {
+        return pool->IsWorkerThread() ? x * 2 : -1;
+    }, scheduler.getFutureResult<int>(read));
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(parse), 42);
+}
+
+TEST(ExecutorTest, BlockingPoolGrowsInsteadOfStallingWorkers) {
+    auto io = std::make_shared<BlockingExecutor>(BlockingExecutorOptions{.max_threads = 8});
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int> done{0};
+    for (int i = 0; i < 8; ++i) {
+        scheduler.on(io).add([&done] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            ++done;
+        });
+    }
+    auto cpu = scheduler.add([] { return 7; });
+    EXPECT_EQ(scheduler.getResult<int>(cpu), 7);
+    EXPECT_LT(done.load(), 8);
+
+    scheduler.executeAll();
+    EXPECT_EQ(done.load(), 8);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_GE(io->Threads(), 2);
+}
+
+TEST(ExecutorTest, BlockingThreadsExitWhenIdle) {
+    BlockingExecutor io(BlockingExecutorOptions{.keep_alive = std::chrono::milliseconds(5)});
+    std::atomic<bool> ran{false};
+    io.Submit([&ran] { ran = true; }, JobOptions{});
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((!ran || io.Threads() != 0) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(ran);
+    EXPECT_EQ(io.Threads(), 0);
+}
+
+TEST(ExecutorTest, InlineChainsDoNotRecurse) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+    auto inline_executor = InlineExecutor::Instance();
+
+    auto ready = scheduler.on(inline_executor).add([] { return 0; });
+    EXPECT_TRUE(ready->IsExecuted());
+
+    // Hold the root until the chain is built so it unwinds from one finish.
+    std::atomic<bool> release{false};
+    auto root = scheduler.add([&release] {
+        release.wait(false);
+        return 0;
+    });
+    std::vector<uintptr_t> frames;
+    auto last = root;
+    for (int i = 0; i < 1000; ++i) {
+        last = scheduler.on(inline_executor).add([&frames](int x) {
+            int marker = 0;
+            frames.push_back(reinterpret_cast<uintptr_t>(&marker));
+            return x + 1;
+        }, scheduler.getFutureResult<int>(last));
+    }
+    release = true;
+    release.notify_one();
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(last), 1000);
+    ASSERT_EQ(frames.size(), 1000);
+    auto [low, high] = std::minmax_element(frames.begin(), frames.end());
+    EXPECT_LT(*high - *low, 4096);
+}
+
+TEST(ExecutorTest, CustomExecutor) {
+    auto custom = std::make_shared<ThreadPerJobExecutor>();
+    {
+        TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+        auto a = scheduler.on(custom).add([] { return 2; });
+        auto b = scheduler.add([](int x) { return x * 10; }, scheduler.getFutureResult<int>(a));
+        auto c = scheduler.on(custom).add([](int x) { return x + 1; },
+                                          scheduler.getFutureResult<int>(b));
+        EXPECT_EQ(scheduler.getResult<int>(c), 21);
+    }
+    EXPECT_EQ(custom->submitted.load(), 2);
+}
+
+TEST(ExecutorTest, SerialSchedulerRejectsExecutors) {
+    TTaskScheduler scheduler;
+    EXPECT_THROW(scheduler.on(std::make_shared<BlockingExecutor>()).add([] { return 1; }),
+                 std::logic_error);
+}
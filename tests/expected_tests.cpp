@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <expected>
+#include <string>
+
+namespace {
+
+std::expected<int, std::string> lookup(int key) {
+    if (key < 0) {
+        return std::unexpected("missing " + std::to_string(key));
+    }
+    return key * 10;
+}
+
+}
+
+TEST(ExpectedTest, ValuesAreUnwrappedForDependents) {
+    TTaskScheduler scheduler;
+
+    auto found = scheduler.add(lookup, 4);
+    auto doubled = scheduler.add([](int x) { return x * 2; },
+                                 scheduler.getFutureResult<std::expected<int, std::string>>(found));
+
+    using Doubled = std::expected<int, std::string>;
+    static_assert(std::is_same_v<decltype(doubled), std::shared_ptr<Task<Doubled>>>);
+
+    scheduler.executeAll();
+    ASSERT_TRUE(scheduler.getResult<Doubled>(doubled).has_value());
+    EXPECT_EQ(*scheduler.getResult<Doubled>(doubled), 80);
+}
+
+TEST(ExpectedTest, ErrorShortCircuitsDependents) {
+    TTaskScheduler scheduler;
+    using Result = std::expected<int, std::string>;
+    using Text = std::expected<std::string, std::string>;
+    using Done = std::expected<void, std::string>;
+
+    int calls = 0;
+    auto found = scheduler.add(lookup, -1);
+    auto first = scheduler.add([&calls](int x) { ++calls; return x + 1; },
+                               scheduler.getFutureResult<Result>(found));
+    auto second = scheduler.add([&calls](int x) { ++calls; return std::to_string(x); },
+                                scheduler.getFutureResult<Result>(first));
+    auto sink = scheduler.add([&calls](const std::string&) { ++calls; },
+                              scheduler.getFutureResult<Text>(second));
+
+    EXPECT_NO_THROW(scheduler.executeAll());
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(scheduler.getResult<Result>(first).error(), "missing -1");
+    EXPECT_EQ(scheduler.getResult<Text>(second).error(), "missing -1");
+    EXPECT_EQ(scheduler.getResult<Done>(sink).error(), "missing -1");
+}
+
+TEST(ExpectedTest, ConsumerMayTakeTheExpectedItself) {
+    TTaskScheduler scheduler;
+    using Result = std::expected<int, std::string>;
+
+    auto found = scheduler.add(lookup, -3);
+    auto fallback = scheduler.add([](const Result& r) { return r.value_or(-1); },
+                                  scheduler.getFutureResult<Result>(found));
+
+    static_assert(std::is_same_v<decltype(fallback), std::shared_ptr<Task<int>>>);
+    EXPECT_EQ(scheduler.getResult<int>(fallback), -1);
+}
+
+TEST(ExpectedTest, FirstErrorWinsAcrossArguments) {
+    TTaskScheduler scheduler;
+    using Result = std::expected<int, std::string>;
+
+    auto good = scheduler.add(lookup, 1);
+    auto bad = scheduler.add(lookup, -2);
+    auto sum = scheduler.add([](int a, int b) { return a + b; },
+                             scheduler.getFutureResult<Result>(good),
+                             scheduler.getFutureResult<Result>(bad));
+    auto chained = scheduler.add([](int a) -> Result { return a + 1; },
+                                 scheduler.getFutureResult<Result>(good));
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<Result>(sum).error(), "missing -2");
+    EXPECT_EQ(*scheduler.getResult<Result>(chained), 11);
+}
+
+TEST(ExpectedTest, EagerErrorsDoNotFailTheGraph) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4});
+    using Result = std::expected<int, std::string>;
+
+    std::atomic<int> calls{0};
+    std::vector<std::shared_ptr<Task<Result>>> results;
+    for (int i = 0; i < 100; ++i) {
+        auto found = scheduler.add(lookup, i % 20 == 0 ? -i - 1 : i);
+        results.push_back(scheduler.add([&calls](int x) { ++calls; return x; },
+                                        scheduler.getFutureResult<Result>(found)));
+    }
+
+    EXPECT_NO_THROW(scheduler.executeAll());
+    EXPECT_EQ(calls.load(), 95);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(scheduler.getResult<Result>(results[i]).has_value(), i % 20 != 0);
+    }
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+class TempDir {
+public:
+    TempDir() {
+        static std::atomic<int> counter{0};
+        path_ = std::filesystem::temp_directory_path() /
+                ("scheduler-file-io-" + std::to_string(::getpid()) + "-" +
+                 std::to_string(counter++));
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TempDir() { std::filesystem::remove_all(path_); }
+
+    std::string file(const std::string& name, const std::string& contents) const {
+        std::string path = (path_ / name).string();
+        std::ofstream(path, std::ios::binary) << contents;
+        return path;
+    }
+
+    std::string path(const std::string& name) const { return (path_ / name).string(); }
+
+private:
+    std::filesystem::path path_;
+};
+
+std::string slurp(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}
+
+TEST(FileIoTest, ReadsCompleteWhileEveryWorkerIsBusy) {
+    TempDir dir;
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    std::atomic<bool> release{false};
+    scheduler.add([&release] { release.wait(false); });
+
+    std::vector<std::shared_ptr<Task<Buffer>>> reads;
+    std::vector<std::shared_ptr<Task<size_t>>> sizes;
+    for (int i = 0; i < 50; ++i) {
+        reads.push_back(scheduler.addRead(dir.file(std::to_string(i), std::string(i * 100, 'x'))));
+        sizes.push_back(scheduler.add([](const Buffer& buffer) { return buffer.size(); },
+                                      scheduler.getFutureResult<Buffer>(reads.back())));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    auto all_read = [&reads] {
+        for (auto& read : reads) {
+            if (!read->IsExecuted()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    while (!all_read() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(all_read());
+    EXPECT_FALSE(sizes.back()->IsExecuted());
+
+    release = true;
+    release.notify_one();
+    scheduler.executeAll();
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(scheduler.getResult<size_t>(sizes[i]), i * 100);
+    }
+}
+
+TEST(FileIoTest, WriteThenReadBack) {
+    TempDir dir;
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto input = scheduler.addRead(dir.file("input", "hello, world"));
+    auto upper = scheduler.add([](const Buffer& buffer) {
+        std::string text(buffer.view());
+        for (char& c : text) {
+            c = static_cast<char>(std::toupper(c));
+        }
+        return Buffer(text);
+    }, scheduler.getFutureResult<Buffer>(input));
+    auto written = scheduler.addWrite(dir.path("output"), scheduler.getFutureResult<Buffer>(upper));
+    auto copy = scheduler.addWrite(dir.path("copy"), Buffer(std::string_view("direct")));
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<size_t>(written), 12);
+    EXPECT_EQ(scheduler.getResult<size_t>(copy), 6);
+
+    auto check = scheduler.addRead(dir.path("output"));
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<Buffer>(check).view(), "HELLO, WORLD");
+    EXPECT_EQ(slurp(dir.path("copy")), "direct");
+}
+
+TEST(FileIoTest, MissingFileFailsTheRead) {
+    TempDir dir;
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto read = scheduler.addRead(dir.path("missing"));
+    std::atomic<bool> ran{false};
+    scheduler.add([&ran](const Buffer&) { ran = true; }, scheduler.getFutureResult<Buffer>(read));
+
+    EXPECT_THROW(scheduler.executeAll(), std::system_error);
+    EXPECT_FALSE(ran);
+}
+
+TEST(FileIoTest, ThreadFallback) {
+    TempDir dir;
+    auto io = std::make_shared<FileIo>(FileIoOptions{.use_io_uring = false});
+    EXPECT_FALSE(io->UsesRing());
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2, .file_io = io});
+
+    std::string contents(1 << 20, 'z');
+    auto read = scheduler.addRead(dir.file("large", contents));
+    auto written = scheduler.addWrite(dir.path("out"), scheduler.getFutureResult<Buffer>(read));
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<Buffer>(read).size(), contents.size());
+    EXPECT_EQ(scheduler.getResult<size_t>(written), contents.size());
+    EXPECT_EQ(slurp(dir.path("out")), contents);
+}
+
+TEST(FileIoTest, SerialSchedulerReadsInPlace) {
+    TempDir dir;
+    TTaskScheduler scheduler;
+
+    auto read = scheduler.addRead(dir.file("input", "abc"));
+    auto size = scheduler.add([](const Buffer& buffer) { return buffer.size(); },
+                              scheduler.getFutureResult<Buffer>(read));
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<size_t>(size), 3);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../lib/scheduler.h"
+#include <cmath>
 #include <string>
 #include <algorithm>
 #include <functional>
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t jobsTaken(const ThreadPool& pool) {
+    uint64_t jobs = 0;
+    for (const WorkerStats& worker : pool.WorkerStatistics()) {
+        jobs += worker.jobs;
+    }
+    return jobs;
+}
+
+// One callable type for every call, so all its runs share a measured cost.
+auto increment() {
+    return [](int x) { return x + 1; };
+}
+
+}
+
+TEST(LatencyTest, ChainRunsOnTheWorkerThatStartedIt) {
+    auto pool = std::make_shared<ThreadPool>(ThreadPoolOptions{.workers = 4});
+    TTaskScheduler scheduler(SchedulerOptions{
+        .pool = pool, .latency = LatencyOptions{.inline_continuations = true}});
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> gate{false};
+    std::vector<std::thread::id> threads(50);
+    auto previous = scheduler.add([&] {
+        started = true;
+        gate.wait(false);
+        threads[0] = std::this_thread::get_id();
+        return 0;
+    });
+    for (int i = 1; i < 50; ++i) {
+        previous = scheduler.add([&threads](int index) {
+            threads[index + 1] = std::this_thread::get_id();
+            return index + 1;
+        }, scheduler.getFutureResult<int>(previous));
+    }
+    while (!started) {
+        std::this_thread::yield();
+    }
+    uint64_t before = jobsTaken(*pool);
+    gate = true;
+    gate.notify_one();
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(previous), 49);
+    // Only the root, taken before the count, went through the queue.
+    EXPECT_EQ(jobsTaken(*pool) - before, 0);
+    for (const auto& thread : threads) {
+        EXPECT_EQ(thread, threads[0]);
+    }
+}
+
+TEST(LatencyTest, MeasuredTinyTasksSkipTheQueue) {
+    auto pool = std::make_shared<ThreadPool>(ThreadPoolOptions{.workers = 2});
+    SchedulerOptions options{.pool = pool,
+                             .latency = LatencyOptions{.inline_below = std::chrono::milliseconds(1)}};
+    {
+        TTaskScheduler warm_up(options);
+        auto root = warm_up.add([] { return 1; });
+        for (int i = 0; i < 64; ++i) {
+            warm_up.add(increment(), warm_up.getFutureResult<int>(root));
+        }
+        warm_up.executeAll();
+    }
+
+    TTaskScheduler scheduler(options);
+    std::atomic<bool> started{false};
+    std::atomic<bool> gate{false};
+    auto root = scheduler.add([&started, &gate] {
+        started = true;
+        gate.wait(false);
+        return 1;
+    });
+    auto first = scheduler.add(increment(), scheduler.getFutureResult<int>(root));
+    auto second = scheduler.add(increment(), scheduler.getFutureResult<int>(root));
+    while (!started) {
+        std::this_thread::yield();
+    }
+    uint64_t before = jobsTaken(*pool);
+    gate = true;
+    gate.notify_one();
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(first), 2);
+    EXPECT_EQ(scheduler.getResult<int>(second), 2);
+    // The root was taken before the count; one dependent was queued and the
+    // other ran on the root's worker.
+    EXPECT_EQ(jobsTaken(*pool) - before, 1);
+}
+
+TEST(LatencyTest, FailuresStillPropagateInline) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2,
+                                              .latency = LatencyOptions::Low()});
+    auto root = scheduler.add([] { return 1; });
+    auto failing = scheduler.add([](int) -> int { throw std::runtime_error("boom"); },
+                                 scheduler.getFutureResult<int>(root));
+    std::atomic<bool> ran{false};
+    scheduler.add([&ran](int) { ran = true; }, scheduler.getFutureResult<int>(failing));
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+    EXPECT_FALSE(ran);
+}
+
+TEST(LatencyTest, SerialSchedulerRejectsLatencyOptions) {
+    EXPECT_THROW(TTaskScheduler(SchedulerOptions{.latency = LatencyOptions::Low()}),
+                 std::logic_error);
+}
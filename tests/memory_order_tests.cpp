@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMegabyte = 1 << 20;
+
+// Adds `width` one-megabyte sources first and their readers after, the
+// insertion order that makes depth-first ordering run every source at once.
+std::vector<std::shared_ptr<Task<size_t>>> addFanOut(TTaskScheduler& scheduler, int width,
+                                                     bool hint) {
+    std::vector<std::shared_ptr<Task<std::vector<char>>>> sources;
+    for (int i = 0; i < width; ++i) {
+        auto make = [i] { return std::vector<char>(kMegabyte, static_cast<char>(i)); };
+        sources.push_back(hint ? scheduler.with(TaskOptions{.result_bytes = kMegabyte}).add(make)
+                               : scheduler.add(make));
+    }
+    std::vector<std::shared_ptr<Task<size_t>>> readers;
+    for (auto& source : sources) {
+        readers.push_back(scheduler.add(
+            [](const std::vector<char>& data) { return data.size() + data.front(); },
+            scheduler.getFutureResult<std::vector<char>>(source)));
+    }
+    return readers;
+}
+
+}
+
+TEST(MemoryOrderTest, RunsBranchesOneAtATime) {
+    TTaskScheduler depth_first;
+    addFanOut(depth_first, 8, true);
+    EXPECT_GE(depth_first.peakMemory().predicted, 8 * kMegabyte);
+
+    TTaskScheduler scheduler(SchedulerOptions{.minimize_peak_memory = true});
+    auto readers = addFanOut(scheduler, 8, true);
+    PeakMemory planned = scheduler.peakMemory();
+    EXPECT_GE(planned.predicted, kMegabyte);
+    EXPECT_LT(planned.predicted, 2 * kMegabyte);
+
+    scheduler.executeAll();
+    for (size_t i = 0; i < readers.size(); ++i) {
+        EXPECT_EQ(scheduler.getResult<size_t>(readers[i]), kMegabyte + i);
+    }
+    PeakMemory measured = scheduler.peakMemory();
+    EXPECT_GE(measured.actual, kMegabyte);
+    EXPECT_LT(measured.actual, 2 * kMegabyte);
+}
+
+TEST(MemoryOrderTest, LearnsSizesFromTheLastRun) {
+    TTaskScheduler scheduler(SchedulerOptions{.minimize_peak_memory = true});
+    addFanOut(scheduler, 4, false);
+    EXPECT_LT(scheduler.peakMemory().predicted, kMegabyte);
+
+    scheduler.executeAll();
+    scheduler.reset();
+    PeakMemory peak = scheduler.peakMemory();
+    EXPECT_GE(peak.predicted, kMegabyte);
+    EXPECT_LT(peak.predicted, 2 * kMegabyte);
+    EXPECT_EQ(peak.actual, 0);
+
+    scheduler.executeAll();
+    EXPECT_LT(scheduler.peakMemory().actual, 2 * kMegabyte);
+}
+
+TEST(MemoryOrderTest, ReducedGraphKeepsResultsLive) {
+    TTaskScheduler scheduler(SchedulerOptions{.minimize_peak_memory = true});
+    auto sized = scheduler.with(TaskOptions{.result_bytes = kMegabyte});
+    auto copy = [](const std::vector<char>& data) { return data; };
+
+    auto first = sized.add([] { return std::vector<char>(kMegabyte, 'a'); });
+    auto second = sized.add(copy, scheduler.getFutureResult<std::vector<char>>(first));
+    auto third = sized.add(copy, scheduler.getFutureResult<std::vector<char>>(second));
+    // Keeps `first` live to the end; the path through `second` implies the edge.
+    auto last = scheduler.add(
+        [](const std::vector<char>& lhs, const std::vector<char>& rhs) {
+            return lhs.size() + rhs.size();
+        },
+        scheduler.getFutureResult<std::vector<char>>(first),
+        scheduler.getFutureResult<std::vector<char>>(third));
+
+    EXPECT_EQ(scheduler.reduceGraph().transitive_edges, 1);
+    PeakMemory planned = scheduler.peakMemory();
+    EXPECT_GE(planned.predicted, 3 * kMegabyte);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<size_t>(last), 2 * kMegabyte);
+    PeakMemory measured = scheduler.peakMemory();
+    EXPECT_GE(measured.actual, 3 * kMegabyte);
+    EXPECT_LT(measured.actual, 4 * kMegabyte);
+}
+
+TEST(MemoryOrderTest, PrioritiesComeFirst) {
+    TTaskScheduler scheduler(SchedulerOptions{.minimize_peak_memory = true});
+    std::vector<int> order;
+    scheduler.add([&order] { order.push_back(0); });
+    scheduler.with(TaskOptions{.priority = 5}).add([&order] { order.push_back(1); });
+    scheduler.executeAll();
+    EXPECT_EQ(order, std::vector<int>({1, 0}));
+}
+
+TEST(MemoryOrderTest, EagerSchedulerRejectsIt) {
+    EXPECT_THROW(TTaskScheduler(SchedulerOptions{.eager = true, .minimize_peak_memory = true}),
+                 std::logic_error);
+}
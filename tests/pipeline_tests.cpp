@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "../lib/pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::shared_ptr<Task<int>> BuildThreeStages(TTaskScheduler& scheduler, FutureResult<int> input) {
+    auto parse = scheduler.add([](int x) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return x;
+    }, input);
+    auto transform = scheduler.add([](int x) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return x * 2;
+    }, scheduler.getFutureResult<int>(parse));
+    return scheduler.add([](int x) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return x + 1;
+    }, scheduler.getFutureResult<int>(transform));
+}
+
+}
+
+TEST(PipelineTest, OrderedDelivery) {
+    std::vector<int> outputs;
+    std::vector<size_t> sequences;
+
+    TPipeline<int, int> pipeline(
+        BuildThreeStages,
+        [&](size_t sequence, const int& output) {
+            sequences.push_back(sequence);
+            outputs.push_back(output);
+        },
+        PipelineOptions{.window = 4, .ordered = true, .workers = 3});
+
+    for (int i = 0; i < 10; ++i) {
+        pipeline.push(i);
+    }
+    pipeline.finish();
+
+    ASSERT_EQ(outputs.size(), 10);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(sequences[i], static_cast<size_t>(i));
+        EXPECT_EQ(outputs[i], i * 2 + 1);
+    }
+}
+
+TEST(PipelineTest, UnorderedDeliveryCoversAllRecords) {
+    std::vector<int> outputs;
+
+    TPipeline<int, int> pipeline(
+        [](TTaskScheduler& scheduler, FutureResult<int> input) {
+            return scheduler.add([](int x) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(x % 3 * 5));
+                return x;
+            }, input);
+        },
+        [&](size_t, const int& output) { outputs.push_back(output); },
+        PipelineOptions{.window = 8, .ordered = false, .workers = 4});
+
+    for (int i = 0; i < 20; ++i) {
+        pipeline.push(i);
+    }
+    pipeline.finish();
+
+    std::sort(outputs.begin(), outputs.end());
+    ASSERT_EQ(outputs.size(), 20);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(outputs[i], i);
+    }
+}
+
+TEST(PipelineTest, WindowBoundsInFlightRecords) {
+    size_t delivered = 0;
+    TPipeline<int, int> pipeline(
+        BuildThreeStages,
+        [&](size_t, const int&) { ++delivered; },
+        PipelineOptions{.window = 2, .workers = 2});
+
+    for (int i = 0; i < 6; ++i) {
+        pipeline.push(i);
+        EXPECT_LE(pipeline.inFlight(), 2);
+    }
+    pipeline.finish();
+    EXPECT_EQ(delivered, 6);
+    EXPECT_EQ(pipeline.inFlight(), 0);
+}
+
+TEST(PipelineTest, RecordsOverlap) {
+    const int records = 12;
+    std::atomic<int> running{0};
+    std::atomic<int> most_running{0};
+    auto stage = [&running, &most_running](int x) {
+        int now = ++running;
+        int seen = most_running.load();
+        while (now > seen && !most_running.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        --running;
+        return x + 1;
+    };
+    TPipeline<int, int> pipeline(
+        [stage](TTaskScheduler& scheduler, FutureResult<int> input) {
+            auto parse = scheduler.add(stage, input);
+            auto transform = scheduler.add(stage, scheduler.getFutureResult<int>(parse));
+            return scheduler.add(stage, scheduler.getFutureResult<int>(transform));
+        },
+        [](size_t, const int&) {},
+        PipelineOptions{.window = 8, .workers = 4});
+
+    for (int i = 0; i < records; ++i) {
+        pipeline.push(i);
+    }
+    pipeline.finish();
+
+    // One record's stages run one after another, so any overlap is between
+    // stages of different records.
+    EXPECT_GE(most_running.load(), 2);
+    EXPECT_LE(most_running.load(), 4);
+}
+
+TEST(PipelineTest, FailedRecordIsReportedFromFinish) {
+    std::vector<int> outputs;
+    TPipeline<int, int> pipeline(
+        [](TTaskScheduler& scheduler, FutureResult<int> input) {
+            return scheduler.add([](int x) {
+                if (x == 2) {
+                    throw std::runtime_error("bad record");
+                }
+                return x;
+            }, input);
+        },
+        [&](size_t, const int& output) { outputs.push_back(output); },
+        PipelineOptions{.window = 2, .workers = 2});
+
+    for (int i = 0; i < 5; ++i) {
+        pipeline.push(i);
+    }
+    EXPECT_THROW(pipeline.finish(), std::runtime_error);
+    EXPECT_EQ(outputs, std::vector<int>({0, 1, 3, 4}));
+}
+
+TEST(PipelineTest, GraphIsBuiltOncePerWindowSlot) {
+    int builds = 0;
+    std::vector<int> outputs;
+    TPipeline<int, int> pipeline(
+        [&builds](TTaskScheduler& scheduler, FutureResult<int> input) {
+            ++builds;
+            return BuildThreeStages(scheduler, input);
+        },
+        [&](size_t, const int& output) { outputs.push_back(output); },
+        PipelineOptions{.window = 3, .workers = 2});
+
+    for (int i = 0; i < 20; ++i) {
+        pipeline.push(i);
+    }
+    pipeline.finish();
+
+    EXPECT_LE(builds, 3);
+    EXPECT_EQ(pipeline.graphsBuilt(), static_cast<size_t>(builds));
+    ASSERT_EQ(outputs.size(), 20);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(outputs[i], i * 2 + 1);
+    }
+}
+
+TEST(PipelineTest, SlotRecoversAfterFailedRecord) {
+    std::vector<int> outputs;
+    TPipeline<int, int> pipeline(
+        [](TTaskScheduler& scheduler, FutureResult<int> input) {
+            return scheduler.add([](int x) {
+                if (x == 0) {
+                    throw std::runtime_error("bad record");
+                }
+                return x;
+            }, input);
+        },
+        [&](size_t, const int& output) { outputs.push_back(output); },
+        PipelineOptions{.window = 1, .workers = 1});
+
+    for (int i = 0; i < 4; ++i) {
+        pipeline.push(i);
+    }
+    EXPECT_THROW(pipeline.finish(), std::runtime_error);
+    EXPECT_EQ(outputs, std::vector<int>({1, 2, 3}));
+    EXPECT_EQ(pipeline.graphsBuilt(), 1);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(PriorityTest, HigherPriorityRunsFirst) {
+    TTaskScheduler scheduler;
+    std::vector<int> order;
+
+    scheduler.add([&order] { order.push_back(1); return 1; });
+    scheduler.with(TaskOptions{.priority = 5}).add([&order] { order.push_back(2); return 2; });
+    scheduler.with(TaskOptions{.priority = 2}).add([&order] { order.push_back(3); return 3; });
+
+    scheduler.executeAll();
+    EXPECT_EQ(order, std::vector<int>({2, 3, 1}));
+}
+
+TEST(PriorityTest, PriorityIsInheritedUpstream) {
+    TTaskScheduler scheduler;
+    std::vector<int> order;
+
+    scheduler.with(TaskOptions{.priority = 1}).add([&order] { order.push_back(0); return 0; });
+    auto source = scheduler.add([&order] { order.push_back(1); return 1; });
+    scheduler.with(TaskOptions{.priority = 3}).add([&order](int x) {
+        order.push_back(2);
+        return x;
+    }, scheduler.getFutureResult<int>(source));
+
+    scheduler.executeAll();
+    EXPECT_EQ(order, std::vector<int>({1, 2, 0}));
+}
+
+TEST(PriorityTest, EarlierDeadlineFirstWithinLevel) {
+    TTaskScheduler scheduler;
+    std::vector<int> order;
+    auto now = std::chrono::steady_clock::now();
+
+    scheduler.with(TaskOptions{.deadline = now + std::chrono::seconds(3)})
+        .add([&order] { order.push_back(3); return 3; });
+    scheduler.with(TaskOptions{.deadline = now + std::chrono::seconds(1)})
+        .add([&order] { order.push_back(1); return 1; });
+    scheduler.with(TaskOptions{.deadline = now + std::chrono::seconds(2)})
+        .add([&order] { order.push_back(2); return 2; });
+
+    scheduler.executeAll();
+    EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+TEST(PriorityTest, EagerQueuePrefersHigherPriority) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    std::atomic<bool> release{false};
+    std::mutex mutex;
+    std::vector<int> order;
+
+    scheduler.add([&release] {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i < 3; ++i) {
+        scheduler.add([&, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        });
+    }
+    scheduler.with(TaskOptions{.priority = 7}).add([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(100);
+    });
+
+    release = true;
+    scheduler.executeAll();
+
+    ASSERT_EQ(order.size(), 4);
+    EXPECT_EQ(order.front(), 100);
+}
+
+TEST(PriorityTest, RejectsPrioritiesOutsideTheLevels) {
+    for (bool eager : {false, true}) {
+        TTaskScheduler scheduler(SchedulerOptions{.eager = eager, .workers = 1});
+        EXPECT_THROW(scheduler.with(TaskOptions{.priority = -1}).add([] { return 0; }),
+                     std::invalid_argument);
+        EXPECT_THROW(scheduler.with(TaskOptions{.priority = ThreadPool::kPriorityLevels})
+                         .add([] { return 0; }),
+                     std::invalid_argument);
+        auto top = scheduler.with(TaskOptions{.priority = ThreadPool::kPriorityLevels - 1})
+                       .add([] { return 1; });
+        scheduler.executeAll();
+        EXPECT_EQ(scheduler.getResult<int>(top), 1);
+    }
+}
+
+TEST(PriorityTest, ExecuteAllWithTimeoutReturnsPartialProgress) {
+    TTaskScheduler scheduler;
+
+    std::vector<std::shared_ptr<Task<int>>> tasks;
+    for (int i = 0; i < 5; ++i) {
+        tasks.push_back(scheduler.add([i] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return i;
+        }));
+    }
+
+    EXPECT_FALSE(scheduler.executeAll(std::chrono::milliseconds(30)));
+
+    size_t executed = 0;
+    for (auto& task : tasks) {
+        executed += task->IsExecuted() ? 1 : 0;
+    }
+    EXPECT_GE(executed, 1);
+    EXPECT_LT(executed, 5);
+
+    EXPECT_TRUE(scheduler.executeAll(std::chrono::seconds(5)));
+    EXPECT_EQ(scheduler.getResult<int>(tasks[4]), 4);
+}
+
+TEST(PriorityTest, EagerExecuteAllWithTimeout) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> release{false};
+    auto urgent = scheduler.with(TaskOptions{.priority = 7}).add([] { return 1; });
+    auto slow = scheduler.add([&release] {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        return 2;
+    });
+
+    EXPECT_FALSE(scheduler.executeAll(std::chrono::milliseconds(20)));
+    EXPECT_TRUE(urgent->IsExecuted());
+    EXPECT_FALSE(slow->IsExecuted());
+
+    release = true;
+    EXPECT_TRUE(scheduler.executeAll(std::chrono::seconds(5)));
+    EXPECT_EQ(scheduler.getResult<int>(slow), 2);
+}
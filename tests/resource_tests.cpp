@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct ConcurrencyProbe {
+    std::atomic<int> current{0};
+    std::atomic<int> peak{0};
+
+    void Enter() {
+        int now = ++current;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+    }
+
+    void Leave() { --current; }
+};
+
+}
+
+TEST(ResourceTest, MemoryBudgetLimitsConcurrency) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4, .memory_budget = 8});
+
+    ConcurrencyProbe probe;
+    std::vector<std::shared_ptr<Task<int>>> tasks;
+    for (int i = 0; i < 6; ++i) {
+        tasks.push_back(scheduler.with(TaskOptions{.memory = 4}).add([&probe, i] {
+            probe.Enter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            probe.Leave();
+            return i;
+        }));
+    }
+
+    scheduler.executeAll();
+
+    EXPECT_LE(probe.peak.load(), 2);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(scheduler.getResult<int>(tasks[i]), i);
+    }
+}
+
+TEST(ResourceTest, ClassLimitStillFillsIdleWorkers) {
+    TTaskScheduler scheduler(SchedulerOptions{
+        .eager = true, .workers = 3, .resource_limits = {{"license", 1}}});
+
+    ConcurrencyProbe licensed;
+    std::atomic<bool> licensedRunning{false};
+    std::atomic<int> overlapped{0};
+
+    for (int i = 0; i < 3; ++i) {
+        scheduler.with(TaskOptions{.resources = {{"license", 1}}}).add([&] {
+            licensed.Enter();
+            licensedRunning = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(15));
+            licensedRunning = false;
+            licensed.Leave();
+        });
+    }
+    for (int i = 0; i < 3; ++i) {
+        scheduler.add([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            if (licensedRunning.load()) {
+                ++overlapped;
+            }
+        });
+    }
+
+    scheduler.executeAll();
+
+    EXPECT_EQ(licensed.peak.load(), 1);
+    EXPECT_GT(overlapped.load(), 0);
+}
+
+TEST(ResourceTest, BlockedTaskRunsAfterDependencies) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2, .memory_budget = 10});
+
+    auto first = scheduler.with(TaskOptions{.memory = 10}).add([] { return 1; });
+    auto second = scheduler.with(TaskOptions{.memory = 10}).add(
+        [](int x) { return x + 1; }, scheduler.getFutureResult<int>(first));
+    auto third = scheduler.with(TaskOptions{.memory = 10}).add([] { return 3; });
+
+    EXPECT_EQ(scheduler.getResult<int>(second), 2);
+    EXPECT_EQ(scheduler.getResult<int>(third), 3);
+}
+
+TEST(ResourceTest, ResourcesReleasedOnFailure) {
+    TTaskScheduler scheduler(SchedulerOptions{
+        .eager = true, .workers = 2, .resource_limits = {{"gpu", 1}}});
+
+    scheduler.with(TaskOptions{.resources = {{"gpu", 1}}}).add([]() -> int {
+        throw std::runtime_error("gpu task failed");
+    });
+    auto next = scheduler.with(TaskOptions{.resources = {{"gpu", 1}}}).add([] { return 5; });
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+    EXPECT_EQ(scheduler.getResult<int>(next), 5);
+}
+
+TEST(ResourceTest, OversizedRequestIsRejected) {
+    TTaskScheduler scheduler(SchedulerOptions{
+        .eager = true, .workers = 1, .memory_budget = 4, .resource_limits = {{"license", 1}}});
+
+    EXPECT_THROW(scheduler.with(TaskOptions{.memory = 5}).add([] { return 1; }),
+                 std::invalid_argument);
+    EXPECT_THROW(scheduler.with(TaskOptions{.resources = {{"license", 2}}}).add([] { return 1; }),
+                 std::invalid_argument);
+
+    auto task = scheduler.add([] { return 2; });
+    EXPECT_EQ(scheduler.getResult<int>(task), 2);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void work() {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+// Holds the runtime's only worker until opened, so every job after it is
+// queued before the first pick.
+class Gate {
+public:
+    explicit Gate(Runtime& runtime) : tenant_(runtime.AddTenant("gate")) {
+        tenant_->Submit([this] {
+            started_ = true;
+            started_.notify_one();
+            open_.wait(false);
+        }, JobOptions{});
+        started_.wait(false);
+    }
+
+    ~Gate() { Open(); }
+
+    void Open() {
+        open_ = true;
+        open_.notify_one();
+    }
+
+private:
+    std::atomic<bool> started_{false};
+    std::atomic<bool> open_{false};
+    std::shared_ptr<Tenant> tenant_;
+};
+
+// The order in which jobs of each tenant were picked.
+class PickLog {
+public:
+    void Record(char tenant) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        order_.push_back(tenant);
+    }
+
+    std::string Order() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return order_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::string order_;
+};
+
+}
+
+TEST(RuntimeTest, SchedulersShareOnePool) {
+    auto runtime = std::make_shared<Runtime>(RuntimeOptions{.workers = 2});
+    auto first_tenant = runtime->AddTenant("first");
+    auto second_tenant = runtime->AddTenant("second", 2);
+    {
+        TTaskScheduler first(SchedulerOptions{.tenant = first_tenant});
+        TTaskScheduler second(SchedulerOptions{.tenant = second_tenant});
+
+        auto a = first.add([] { return 20; });
+        auto b = first.add([](int x) { return x + 1; }, first.getFutureResult<int>(a));
+        auto c = second.add([] { return 2; });
+        auto d = second.add([](int x) { return x * 3; }, second.getFutureResult<int>(c));
+        EXPECT_EQ(first.getResult<int>(b), 21);
+        EXPECT_EQ(second.getResult<int>(d), 6);
+    }
+
+    std::vector<TenantUsage> usage = runtime->Usage();
+    ASSERT_EQ(usage.size(), 2);
+    EXPECT_EQ(usage[0].name, "first");
+    EXPECT_EQ(usage[0].jobs, 2);
+    EXPECT_EQ(usage[1].name, "second");
+    EXPECT_EQ(usage[1].weight, 2);
+    EXPECT_EQ(usage[1].jobs, 2);
+    EXPECT_EQ(usage[1].queued, 0);
+}
+
+TEST(RuntimeTest, BatchGraphDoesNotStarveInteractiveOne) {
+    auto runtime = std::make_shared<Runtime>(RuntimeOptions{.workers = 1});
+    Gate gate(*runtime);
+    PickLog log;
+
+    TTaskScheduler batch(SchedulerOptions{.tenant = runtime->AddTenant("batch")});
+    for (int i = 0; i < 500; ++i) {
+        batch.add([&log] {
+            log.Record('b');
+            work();
+        });
+    }
+    TTaskScheduler interactive(SchedulerOptions{.tenant = runtime->AddTenant("interactive")});
+    for (int i = 0; i < 20; ++i) {
+        interactive.add([&log] {
+            log.Record('i');
+            work();
+        });
+    }
+    gate.Open();
+    interactive.executeAll();
+    batch.executeAll();
+
+    // First come first served would run the whole batch first.
+    std::string order = log.Order();
+    ASSERT_EQ(order.size(), 520);
+    size_t last = order.rfind('i');
+    EXPECT_EQ(std::count(order.begin(), order.end(), 'i'), 20);
+    EXPECT_LT(std::count(order.begin(), order.begin() + last, 'b'), 100);
+}
+
+TEST(RuntimeTest, WeightsSplitTheWorkers) {
+    auto runtime = std::make_shared<Runtime>(RuntimeOptions{.workers = 1});
+    Gate gate(*runtime);
+    PickLog log;
+    auto heavy = runtime->AddTenant("heavy", 3);
+    auto light = runtime->AddTenant("light", 1);
+
+    auto job = [&log](char tenant) {
+        return [&log, tenant] {
+            log.Record(tenant);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        };
+    };
+    for (int i = 0; i < 100; ++i) {
+        heavy->Submit(job('h'), JobOptions{});
+        light->Submit(job('l'), JobOptions{});
+    }
+    gate.Open();
+    heavy.reset();
+    light.reset();
+
+    // Equal jobs, so the heavy tenant takes about three picks in four.
+    std::string order = log.Order();
+    ASSERT_EQ(order.size(), 200);
+    auto picks = std::count(order.begin(), order.begin() + 120, 'h');
+    EXPECT_GE(picks, 75);
+    EXPECT_LE(picks, 105);
+}
+
+TEST(RuntimeTest, RejectsNonPositiveWeights) {
+    auto runtime = std::make_shared<Runtime>(RuntimeOptions{.workers = 1});
+    EXPECT_THROW(runtime->AddTenant("zero", 0), std::invalid_argument);
+    EXPECT_THROW(runtime->AddTenant("negative", -1), std::invalid_argument);
+    EXPECT_THROW(runtime->AddTenant("nan", std::nan("")), std::invalid_argument);
+    EXPECT_TRUE(runtime->Usage().empty());
+}
+
+TEST(RuntimeTest, DefaultRuntimeIsShared) {
+    EXPECT_EQ(Runtime::Default(), Runtime::Default());
+    TTaskScheduler scheduler(SchedulerOptions{.tenant = Runtime::Default()->AddTenant("default")});
+    auto task = scheduler.add([] { return 5; });
+    EXPECT_EQ(scheduler.getResult<int>(task), 5);
+}
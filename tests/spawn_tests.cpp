@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int64_t fib(TaskContext& context, int n) {
+    if (n < 2) {
+        return n;
+    }
+    auto left = context.spawn([n](TaskContext& child) { return fib(child, n - 1); });
+    int64_t right = fib(context, n - 2);
+    return context.wait(left) + right;
+}
+
+void quickSort(TaskContext& context, std::vector<int>::iterator begin,
+               std::vector<int>::iterator end) {
+    if (end - begin < 256) {
+        std::sort(begin, end);
+        return;
+    }
+    int pivot = *(begin + (end - begin) / 2);
+    auto middle = std::partition(begin, end, [pivot](int x) { return x < pivot; });
+    auto upper = std::partition(middle, end, [pivot](int x) { return x == pivot; });
+    context.spawn([begin, middle](TaskContext& child) { quickSort(child, begin, middle); });
+    quickSort(context, upper, end);
+}
+
+std::chrono::nanoseconds ThreadCpuTime() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+}
+
+TEST(SpawnTest, RecursiveFibonacci) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4});
+    auto task = scheduler.add([](TaskContext& context) { return fib(context, 22); });
+    auto doubled = scheduler.add([](int64_t x) { return x * 2; },
+                                 scheduler.getFutureResult<int64_t>(task));
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int64_t>(task), 17711);
+    EXPECT_EQ(scheduler.getResult<int64_t>(doubled), 35422);
+}
+
+TEST(SpawnTest, ChildrenNotWaitedOnAreJoinedBeforeTheTaskFinishes) {
+    std::vector<int> values(200000);
+    std::mt19937 random(42);
+    for (int& value : values) {
+        value = static_cast<int>(random() % 100000);
+    }
+    std::vector<int> expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4});
+    scheduler.add([&values](TaskContext& context) {
+        quickSort(context, values.begin(), values.end());
+    });
+    scheduler.executeAll();
+    EXPECT_EQ(values, expected);
+}
+
+TEST(SpawnTest, OneWorkerWaitsByRunningTheChildren) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+    auto task = scheduler.add([](TaskContext& context) { return fib(context, 16); });
+    EXPECT_EQ(scheduler.getResult<int64_t>(task), 987);
+}
+
+TEST(SpawnTest, ChildErrorsReachTheParent) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto caught = scheduler.add([](TaskContext& context) {
+        auto child = context.spawn([]() -> int { throw std::runtime_error("child"); });
+        try {
+            context.wait(child);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    });
+    auto forgotten = scheduler.add([](TaskContext& context) {
+        context.spawn([] { throw std::runtime_error("forgotten"); });
+    });
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+    EXPECT_TRUE(scheduler.getResult<bool>(caught));
+    EXPECT_THROW(scheduler.wait(forgotten), std::runtime_error);
+}
+
+TEST(SpawnTest, SerialSchedulerRunsChildrenAsTheyAreSpawned) {
+    TTaskScheduler scheduler;
+    std::vector<int> order;
+    auto task = scheduler.add([&order](TaskContext& context) -> int64_t {
+        auto child = context.spawn([&order] {
+            order.push_back(1);
+            return 10;
+        });
+        order.push_back(2);
+        return context.wait(child) + fib(context, 10);
+    });
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int64_t>(task), 65);
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST(SpawnTest, ParentWaitingOnRunningChildParks) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+    auto task = scheduler.add([](TaskContext& context) {
+        std::atomic<bool> started{false};
+        auto child = context.spawn([&started] {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return 1;
+        });
+        while (!started.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto start = ThreadCpuTime();
+        context.wait(child);
+        return ThreadCpuTime() - start;
+    });
+    EXPECT_LT(scheduler.getResult<std::chrono::nanoseconds>(task), std::chrono::milliseconds(50));
+}
+
+TEST(SpawnTest, ChildrenInheritTheParentsPriority) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    std::atomic<bool> release{false};
+    scheduler.add([&release] {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::vector<int> order;
+    std::shared_ptr<Task<void>> last;
+    scheduler.with(TaskOptions{.priority = 7}).add([&](TaskContext& context) {
+        auto child = context.spawn([&order] { order.push_back(0); });
+        scheduler.wait(last, true);
+        context.wait(child);
+    });
+    for (int i = 1; i <= 3; ++i) {
+        last = scheduler.with(TaskOptions{.priority = 3}).add([&order, i] { order.push_back(i); });
+    }
+
+    release = true;
+    scheduler.executeAll();
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(SpawnTest, TenantChildrenGoThroughTheRuntime) {
+    auto runtime = std::make_shared<Runtime>(RuntimeOptions{.workers = 1});
+    auto tenant = runtime->AddTenant("spawning");
+    TTaskScheduler scheduler(SchedulerOptions{.tenant = tenant});
+
+    auto task = scheduler.add([&tenant](TaskContext& context) {
+        auto child = context.spawn([] { return 2; });
+        size_t queued = tenant->Usage().queued;
+        return context.wait(child) * 10 + static_cast<int>(queued);
+    });
+    EXPECT_EQ(scheduler.getResult<int>(task), 21);
+}
@@ -189,4 +189,46 @@ TEST(SpecialCasesTest, OnlyNecessaryTasksExecuted) {
     EXPECT_TRUE(executed1);
     EXPECT_TRUE(executed2);
     EXPECT_FALSE(executed3);
-}
\ No newline at end of file
+}
+
+TEST(SpecialCasesTest, RunnerDoesNotReenterDependencies) {
+    TTaskScheduler scheduler;
+
+    int calls1 = 0, calls2 = 0;
+    auto task1 = scheduler.add([&calls1]() {
+        ++calls1;
+        return 20;
+    });
+    auto task2 = scheduler.add([&calls2](int x) {
+        ++calls2;
+        return x + 1;
+    }, scheduler.getFutureResult<int>(task1));
+
+    task1->Runner()(task1.get());
+    task2->Runner()(task2.get());
+    task2->Runner()(task2.get());
+
+    EXPECT_EQ(calls1, 1);
+    EXPECT_EQ(calls2, 1);
+    EXPECT_TRUE(task2->IsExecuted());
+    EXPECT_EQ(scheduler.getResult<int>(task2), 21);
+}
+
+TEST(SpecialCasesTest, TaskStatusOutlivesScheduler) {
+    std::shared_ptr<Task<int>> task;
+    std::shared_ptr<Task<int>> skipped;
+    {
+        TTaskScheduler scheduler;
+        task = scheduler.add([]() { return 7; });
+        skipped = scheduler.add([]() { return 8; });
+        scheduler.executeAll();
+        skipped->Reset();
+    }
+
+    EXPECT_TRUE(task->IsExecuted());
+    EXPECT_FALSE(skipped->IsExecuted());
+    EXPECT_EQ(task->GetResult(), 7);
+
+    task->Reset();
+    EXPECT_FALSE(task->IsExecuted());
+}
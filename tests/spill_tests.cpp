@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <algorithm>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMegabyte = 1 << 20;
+
+std::vector<char> block(char fill) {
+    return std::vector<char>(kMegabyte, fill);
+}
+
+}
+
+TEST(SpillTest, SpillsTheResultNeededLast) {
+    TTaskScheduler scheduler(SchedulerOptions{.result_budget = 3 * kMegabyte / 2});
+
+    auto soon = scheduler.add([] { return block('a'); });
+    auto later = scheduler.add([] { return block('b'); });
+    bool later_spilled = false;
+    bool soon_spilled = true;
+    auto first = scheduler.add([&](const std::vector<char>& data) {
+        later_spilled = later->IsSpilled();
+        soon_spilled = soon->IsSpilled();
+        return data.front();
+    }, scheduler.getFutureResult<std::vector<char>>(soon));
+    auto second = scheduler.add([](const std::vector<char>& data) { return data.back(); },
+                                scheduler.getFutureResult<std::vector<char>>(later));
+    scheduler.executeAll();
+
+    EXPECT_TRUE(later_spilled);
+    EXPECT_FALSE(soon_spilled);
+    EXPECT_EQ(scheduler.getResult<char>(first), 'a');
+    EXPECT_EQ(scheduler.getResult<char>(second), 'b');
+
+    SchedulerStats stats = scheduler.stats();
+    EXPECT_GE(stats.results_spilled, 1);
+    EXPECT_GE(stats.results_restored, 1);
+    EXPECT_GE(stats.bytes_spilled, kMegabyte);
+}
+
+TEST(SpillTest, RestoredInputsStayWithinBudget) {
+    TTaskScheduler scheduler(SchedulerOptions{.result_budget = 3 * kMegabyte / 2});
+
+    auto reread = scheduler.add([] { return block('x'); });
+    auto spilled = scheduler.add([] { return block('y'); });
+    scheduler.add([](const std::vector<char>& data) { return data.front(); },
+                  scheduler.getFutureResult<std::vector<char>>(reread));
+    bool other_spilled = false;
+    scheduler.add([&](const std::vector<char>& data) {
+        other_spilled = reread->IsSpilled();
+        return data.front();
+    }, scheduler.getFutureResult<std::vector<char>>(spilled));
+    auto last = scheduler.add([](const std::vector<char>& data) { return data.back(); },
+                              scheduler.getFutureResult<std::vector<char>>(reread));
+    scheduler.executeAll();
+
+    EXPECT_TRUE(other_spilled);
+    EXPECT_EQ(scheduler.getResult<char>(last), 'x');
+    SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.results_restored, 2);
+    EXPECT_GE(stats.results_spilled, 2);
+}
+
+TEST(SpillTest, ReducedGraphStaysWithinBudget) {
+    TTaskScheduler scheduler(SchedulerOptions{.result_budget = 5 * kMegabyte / 2});
+
+    std::vector<std::shared_ptr<Task<std::vector<char>>>> blocks;
+    size_t most_resident = 0;
+    auto check = [&blocks, &most_resident] {
+        size_t resident = 0;
+        for (auto& task : blocks) {
+            if (task->IsExecuted() && !task->IsSpilled()) {
+                ++resident;
+            }
+        }
+        most_resident = std::max(most_resident, resident);
+    };
+
+    auto first = scheduler.add([] { return block('a'); });
+    auto second = scheduler.add([](const std::vector<char>& data) { return data; },
+                                scheduler.getFutureResult<std::vector<char>>(first));
+    auto unrelated = scheduler.add([] { return block('x'); });
+    blocks = {first, second, unrelated};
+    // Reads `first` again, an edge that the path through `second` implies.
+    auto both = scheduler.add([&check](const std::vector<char>& lhs, const std::vector<char>& rhs) {
+        check();
+        return lhs.front() + rhs.back();
+    }, scheduler.getFutureResult<std::vector<char>>(first),
+       scheduler.getFutureResult<std::vector<char>>(second));
+    auto later = scheduler.add([&check](const std::vector<char>& data) {
+        check();
+        return data.front();
+    }, scheduler.getFutureResult<std::vector<char>>(unrelated));
+
+    EXPECT_EQ(scheduler.reduceGraph().transitive_edges, 1);
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(both), 'a' + 'a');
+    EXPECT_EQ(scheduler.getResult<char>(later), 'x');
+    EXPECT_LE(most_resident, 2);
+
+    // Reading a spilled result back outside a run is budgeted the same way.
+    scheduler.getResult<std::vector<char>>(first);
+    scheduler.getResult<std::vector<char>>(second);
+    scheduler.getResult<std::vector<char>>(unrelated);
+    check();
+    EXPECT_LE(most_resident, 2);
+}
+
+TEST(SpillTest, GraphLargerThanBudgetFinishes) {
+    TTaskScheduler scheduler(SchedulerOptions{.result_budget = 4 * kMegabyte});
+
+    std::vector<std::shared_ptr<Task<std::vector<char>>>> blocks;
+    for (int i = 0; i < 32; ++i) {
+        blocks.push_back(scheduler.add([i] { return block(static_cast<char>(i)); }));
+    }
+    std::vector<std::shared_ptr<Task<long>>> sums;
+    for (int i = 0; i + 1 < 32; i += 2) {
+        sums.push_back(scheduler.add(
+            [](const std::vector<char>& lhs, const std::vector<char>& rhs) {
+                return std::accumulate(lhs.begin(), lhs.end(), 0L) +
+                       std::accumulate(rhs.begin(), rhs.end(), 0L);
+            },
+            scheduler.getFutureResult<std::vector<char>>(blocks[i]),
+            scheduler.getFutureResult<std::vector<char>>(blocks[i + 1])));
+    }
+    scheduler.executeAll();
+
+    for (size_t i = 0; i < sums.size(); ++i) {
+        long expected = static_cast<long>(kMegabyte) * static_cast<long>(4 * i + 1);
+        EXPECT_EQ(scheduler.getResult<long>(sums[i]), expected);
+    }
+    EXPECT_GE(scheduler.stats().results_spilled, 24);
+    EXPECT_EQ(scheduler.getResult<std::vector<char>>(blocks.front()), block(0));
+}
+
+TEST(SpillTest, ResetRecomputesSpilledResults) {
+    TTaskScheduler scheduler(SchedulerOptions{.result_budget = 1});
+
+    int runs = 0;
+    auto text = scheduler.add([&runs] {
+        ++runs;
+        return std::string(1000, 'x') + std::to_string(runs);
+    });
+    auto opaque = scheduler.add([] { return std::list<int>{1, 2, 3}; });
+    scheduler.executeAll();
+    EXPECT_TRUE(text->IsSpilled());
+    EXPECT_FALSE(opaque->IsSpilled());
+
+    scheduler.reset();
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<std::string>(text).back(), '2');
+    EXPECT_FALSE(text->IsSpilled());
+}
+
+TEST(SpillTest, EagerSchedulerRejectsBudget) {
+    EXPECT_THROW(TTaskScheduler(SchedulerOptions{.eager = true, .result_budget = 1}),
+                 std::logic_error);
+}
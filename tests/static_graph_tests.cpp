@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "../lib/static_graph.h"
+#include <cmath>
+#include <string>
+
+namespace {
+
+using A = StaticInput<0, float>;
+using B = StaticInput<1, float>;
+using C = StaticInput<2, float>;
+
+using Id1 = StaticNode<[](float a, float c) { return -4 * a * c; }, A, C>;
+using Id2 = StaticNode<[](float b, float v) { return b * b + v; }, B, Id1>;
+using Id3 = StaticNode<[](float b, float d) { return -b + std::sqrt(d); }, B, Id2>;
+using Id4 = StaticNode<[](float b, float d) { return -b - std::sqrt(d); }, B, Id2>;
+using Id5 = StaticNode<[](float a, float v) { return v / (2 * a); }, A, Id3>;
+using Id6 = StaticNode<[](float a, float v) { return v / (2 * a); }, A, Id4>;
+
+int baseRuns = 0;
+
+using Base = StaticNode<[] { ++baseRuns; return 10; }>;
+using Left = StaticNode<[](int x) { return x + 5; }, Base>;
+using Right = StaticNode<[](int x) { return x * 2; }, Base>;
+using Join = StaticNode<[](int l, int r) { return l + r; }, Left, Right>;
+
+}
+
+TEST(StaticGraphTest, QuadraticEquation) {
+    TStaticGraph<Id5, Id6> graph;
+    graph.executeAll(1.0f, -2.0f, 0.0f);
+
+    EXPECT_FLOAT_EQ(graph.getResult<Id5>(), 2.0f);
+    EXPECT_FLOAT_EQ(graph.getResult<Id6>(), 0.0f);
+    EXPECT_FLOAT_EQ(graph.getResult<Id2>(), 4.0f);
+
+    graph.executeAll(1.0f, -5.0f, 6.0f);
+    EXPECT_FLOAT_EQ(graph.getResult<Id5>(), 3.0f);
+    EXPECT_FLOAT_EQ(graph.getResult<Id6>(), 2.0f);
+}
+
+TEST(StaticGraphTest, OrderIsTopologicalAndDeduplicated) {
+    using Graph = TStaticGraph<Join>;
+
+    static_assert(Graph::size() == 4);
+    static_assert(Graph::position<Base>() < Graph::position<Left>());
+    static_assert(Graph::position<Base>() < Graph::position<Right>());
+    static_assert(Graph::position<Left>() < Graph::position<Join>());
+    static_assert(Graph::position<Right>() < Graph::position<Join>());
+
+    baseRuns = 0;
+    Graph graph;
+    graph.executeAll();
+
+    EXPECT_EQ(baseRuns, 1);
+    EXPECT_EQ(graph.getResult<Join>(), 35);
+}
+
+TEST(StaticGraphTest, NonTrivialResultTypes) {
+    using Name = StaticInput<0, std::string>;
+    using Greeting = StaticNode<[](const std::string& name) { return "Hello, " + name; }, Name>;
+    using Length = StaticNode<[](const std::string& s) { return s.size(); }, Greeting>;
+
+    TStaticGraph<Length, Greeting> graph;
+    graph.executeAll(std::string("World"));
+
+    EXPECT_EQ(graph.getResult<Greeting>(), "Hello, World");
+    EXPECT_EQ(graph.getResult<Length>(), 12);
+}
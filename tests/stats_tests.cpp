@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(LatencyHistogramTest, BucketsStayWithinRelativeError) {
+    for (uint64_t value : std::vector<uint64_t>{0, 7, 15, 16, 31, 1000, 123456789, UINT64_MAX}) {
+        size_t bucket = LatencyHistogram::BucketOf(value);
+        ASSERT_LT(bucket, LatencyHistogram::kBuckets);
+        EXPECT_LE(LatencyHistogram::LowestOf(bucket), value);
+        EXPECT_GE(LatencyHistogram::HighestOf(bucket), value);
+        EXPECT_LE(LatencyHistogram::HighestOf(bucket) - LatencyHistogram::LowestOf(bucket),
+                  value / LatencyHistogram::kSubBuckets);
+    }
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        histogram.Record(i * 1000);
+    }
+
+    EXPECT_EQ(histogram.Count(), 1000);
+    EXPECT_EQ(histogram.Min(), 1000);
+    EXPECT_EQ(histogram.Max(), 1000000);
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 500500.0);
+    EXPECT_NEAR(histogram.ValueAtPercentile(50), 500000, 500000 / 16);
+    EXPECT_NEAR(histogram.ValueAtPercentile(99), 990000, 990000 / 16);
+    EXPECT_EQ(histogram.ValueAtPercentile(100), 1000000);
+
+    LatencyHistogram other;
+    other.Record(5);
+    histogram.Merge(other);
+    EXPECT_EQ(histogram.Count(), 1001);
+    EXPECT_EQ(histogram.Min(), 5);
+}
+
+TEST(StatsTest, SerialCountsTasksAndTopSort) {
+    if (!kStatsEnabled) {
+        GTEST_SKIP() << "built with SCHEDULER_STATS=0";
+    }
+    TTaskScheduler scheduler;
+
+    auto first = scheduler.add([] { return 1; });
+    auto second = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(first));
+    scheduler.add([](int) { throw std::runtime_error("boom"); },
+                  scheduler.getFutureResult<int>(second));
+
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+
+    SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.tasks_added, 3);
+    EXPECT_EQ(stats.tasks_executed, 2);
+    EXPECT_EQ(stats.tasks_failed, 1);
+    EXPECT_EQ(stats.topsorts, 1);
+    EXPECT_GE(stats.task_durations.Count(), 1);
+    EXPECT_LE(stats.task_durations.Count(), 3);
+    EXPECT_TRUE(stats.workers.empty());
+}
+
+TEST(StatsTest, EagerReportsWorkersAndQueueDepth) {
+    if (!kStatsEnabled) {
+        GTEST_SKIP() << "built with SCHEDULER_STATS=0";
+    }
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 4});
+
+    const int tasks = 200;
+    for (int i = 0; i < tasks; ++i) {
+        scheduler.add([] { std::this_thread::sleep_for(std::chrono::microseconds(50)); });
+    }
+    scheduler.executeAll();
+
+    SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.tasks_added, tasks);
+    EXPECT_EQ(stats.tasks_executed, tasks);
+    EXPECT_EQ(stats.tasks_failed, 0);
+    EXPECT_GE(stats.ready_queue_depths.Count(), 1);
+    EXPECT_LE(stats.ready_queue_depths.Count(), tasks);
+    EXPECT_GE(stats.task_durations.ValueAtPercentile(50), 50000);
+    EXPECT_GE(stats.task_time, std::chrono::microseconds(50 * tasks));
+    EXPECT_GT(stats.overhead_time.count(), 0);
+
+    ASSERT_EQ(stats.workers.size(), 4);
+    uint64_t jobs = 0;
+    for (const WorkerStats& worker : stats.workers) {
+        jobs += worker.jobs;
+    }
+    EXPECT_EQ(jobs, tasks);
+}
+
+TEST(StatsTest, ShardStaysSmallUntilHistogramsAreUsed) {
+    EXPECT_LE(sizeof(StatsShard), 128);
+
+    StatsShard shard;
+    shard.RecordSample(1000);
+    shard.RecordQueueDepth(3);
+    SchedulerStats stats;
+    shard.AddTo(stats);
+    EXPECT_EQ(stats.task_durations.Count(), 1);
+    EXPECT_EQ(stats.task_durations.Min(), 1000);
+    EXPECT_EQ(stats.ready_queue_depths.ValueAtPercentile(100), 3);
+}
+
+TEST(StatsTest, ManySchedulersOnOneThreadKeepTheirOwnShards) {
+    if (!kStatsEnabled) {
+        GTEST_SKIP() << "built with SCHEDULER_STATS=0";
+    }
+    const int count = 100;
+    std::vector<std::unique_ptr<TTaskScheduler>> schedulers;
+    for (int i = 0; i < count; ++i) {
+        schedulers.push_back(std::make_unique<TTaskScheduler>());
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < count; ++i) {
+            for (int j = 0; j <= i % 5; ++j) {
+                schedulers[i]->add([] { return 1; });
+            }
+            schedulers[i]->executeAll();
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(schedulers[i]->stats().tasks_executed, 3 * (i % 5 + 1)) << i;
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_trivially_copyable_v<TaskRef<int>>);
+static_assert(sizeof(TaskRef<int>) == 8);
+
+TEST(TaskRefTest, ResolvesResultsThroughScheduler) {
+    TTaskScheduler scheduler;
+
+    auto ref = scheduler.getRef(scheduler.add([]() { return 20; }));
+    auto doubled = scheduler.getRef(scheduler.add([](int x) { return x * 2; },
+                                                  scheduler.getFutureResult(ref)));
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult(ref), 20);
+    EXPECT_EQ(scheduler.getResult(doubled), 40);
+    EXPECT_TRUE(scheduler.getTask(doubled)->IsExecuted());
+}
+
+TEST(TaskRefTest, ForeignReferenceIsRejected) {
+    TTaskScheduler first;
+    TTaskScheduler second;
+
+    auto task = first.add([]() { return 1; });
+    auto ref = first.getRef(task);
+
+    EXPECT_THROW(second.getResult(ref), std::out_of_range);
+    EXPECT_THROW(second.getRef(task), std::invalid_argument);
+    EXPECT_FALSE(TaskRef<int>());
+    EXPECT_TRUE(ref);
+}
+
+TEST(TaskRefTest, FutureCopiesDoNotTouchRefcount) {
+    TTaskScheduler scheduler;
+
+    auto producer = scheduler.add([]() { return 3; });
+    long before = producer.use_count();
+
+    std::vector<FutureResult<int>> copies(1000, scheduler.getFutureResult<int>(producer));
+    EXPECT_EQ(producer.use_count(), before);
+    EXPECT_EQ(copies.back().getTask(), producer);
+}
+
+TEST(TaskRefTest, EscapeHatchOutlivesScheduler) {
+    std::shared_ptr<Task<int>> kept;
+    {
+        TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+        auto ref = scheduler.getRef(scheduler.add([]() { return 5; }));
+        std::atomic<int> sum{0};
+        for (int i = 0; i < 100; ++i) {
+            scheduler.add([&sum](int x) { sum += x; }, scheduler.getFutureResult(ref));
+        }
+        scheduler.executeAll();
+        EXPECT_EQ(sum.load(), 500);
+        kept = scheduler.getTask(ref);
+    }
+    EXPECT_EQ(kept->GetResult(), 5);
+}
+
+TEST(TaskRefTest, ReaderKeepsFutureValidAfterScheduler) {
+    std::shared_ptr<Task<int>> reader;
+    std::weak_ptr<Task<int>> watched;
+    std::optional<FutureResult<int>> future;
+    {
+        TTaskScheduler scheduler;
+        auto producer = scheduler.add([]() { return 7; });
+        watched = producer;
+        future.emplace(scheduler.getFutureResult<int>(producer));
+        reader = scheduler.add([](int x) { return x + 1; }, *future);
+        scheduler.executeAll();
+    }
+    ASSERT_FALSE(watched.expired());
+    EXPECT_EQ(future->get(), 7);
+    EXPECT_EQ(reader->GetResult(), 8);
+
+    reader.reset();
+    EXPECT_TRUE(watched.expired());
+}
+
+TEST(TaskRefTest, EachEdgeOwnsOneReference) {
+    TTaskScheduler scheduler;
+
+    auto producer = scheduler.add([]() { return 1; });
+    long before = producer.use_count();
+    auto future = scheduler.getFutureResult<int>(producer);
+    for (int i = 0; i < 10; ++i) {
+        scheduler.add([](int x) { return x; }, future);
+    }
+    EXPECT_EQ(producer.use_count(), before + 10);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST(TopologyTest, DetectFindsAtLeastOneCpu) {
+    CpuTopology topology = CpuTopology::Detect();
+    ASSERT_GE(topology.NodeCount(), 1);
+    for (const auto& cpus : topology.nodes) {
+        EXPECT_FALSE(cpus.empty());
+    }
+}
+
+TEST(ThreadPoolTest, RunsEverySubmittedJob) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(ThreadPoolOptions{.workers = 4});
+        for (int i = 0; i < 1000; ++i) {
+            pool.Submit([&counter] { ++counter; });
+        }
+    }
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(ThreadPoolTest, CurrentNodeInsideAndOutsideWorkers) {
+    EXPECT_EQ(ThreadPool::CurrentNode(), -1);
+
+    std::atomic<int> node{-2};
+    {
+        ThreadPool pool(ThreadPoolOptions{.workers = 2, .pin_workers = true});
+        pool.Submit([&node] { node = ThreadPool::CurrentNode(); }, 0);
+    }
+    EXPECT_EQ(node.load(), 0);
+}
+
+TEST(ThreadPoolTest, JobsSubmittedFromWorkersRun) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(ThreadPoolOptions{.workers = 3});
+        for (int i = 0; i < 10; ++i) {
+            pool.Submit([&pool, &counter] {
+                for (int j = 0; j < 10; ++j) {
+                    pool.Submit([&counter] { ++counter; });
+                }
+            });
+        }
+    }
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(ThreadPoolTest, LocalityHintOnAdd) {
+    auto pool = std::make_shared<ThreadPool>(ThreadPoolOptions{.workers = 2});
+    TTaskScheduler scheduler(SchedulerOptions{.pool = pool});
+
+    auto root = scheduler.with(TaskOptions{.node = 0}).add([] {
+        return ThreadPool::CurrentNode();
+    });
+    auto child = scheduler.add([](int node) { return node + 1; },
+                               scheduler.getFutureResult<int>(root));
+
+    EXPECT_EQ(scheduler.getResult<int>(root), 0);
+    EXPECT_EQ(scheduler.getResult<int>(child), 1);
+}
+
+TEST(ThreadPoolTest, WithIgnoredByLazyScheduler) {
+    TTaskScheduler scheduler;
+    auto task = scheduler.with(TaskOptions{.node = 3}).add([] { return 7; });
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(task), 7);
+}
+
+TEST(ThreadPoolTest, SpinningWorkersPickUpJobsAndPark) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(ThreadPoolOptions{.workers = 2, .spin = std::chrono::microseconds(200)});
+        for (int i = 0; i < 100; ++i) {
+            pool.Submit([&counter] { ++counter; });
+            if (i % 10 == 0) {
+                // Long enough for the spin to give out and the workers to park.
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+    EXPECT_EQ(counter.load(), 100);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(TimingWheelTest, FiresAcrossLevelsInOrder) {
+    TimingWheel wheel;
+    std::vector<int> order;
+    std::vector<Function<void>> fired;
+
+    wheel.Schedule(70000, [&order] { order.push_back(3); });
+    wheel.Schedule(5, [&order] { order.push_back(1); });
+    wheel.Schedule(300, [&order] { order.push_back(2); });
+    wheel.Schedule(20000000, [&order] { order.push_back(4); });
+    EXPECT_EQ(wheel.Size(), 4);
+
+    wheel.Advance(4, fired);
+    EXPECT_TRUE(fired.empty());
+
+    wheel.Advance(5, fired);
+    ASSERT_EQ(fired.size(), 1);
+
+    wheel.Advance(69999, fired);
+    EXPECT_EQ(fired.size(), 2);
+
+    wheel.Advance(70000, fired);
+    EXPECT_EQ(fired.size(), 3);
+
+    wheel.Advance(20000000, fired);
+    ASSERT_EQ(fired.size(), 4);
+
+    for (auto& callback : fired) {
+        callback();
+    }
+    EXPECT_EQ(order, std::vector<int>({1, 2, 3, 4}));
+    EXPECT_EQ(wheel.Size(), 0);
+}
+
+TEST(TimingWheelTest, NextTickSkipsEmptySlots) {
+    TimingWheel wheel;
+    std::vector<Function<void>> fired;
+    EXPECT_EQ(wheel.NextTick(), UINT64_MAX);
+
+    wheel.Schedule(3600000, [] {});
+    wheel.Schedule(40, [] {});
+    EXPECT_EQ(wheel.NextTick(), 40);
+
+    wheel.Advance(40, fired);
+    EXPECT_EQ(fired.size(), 1);
+
+    uint64_t woken = 0;
+    while (fired.size() == 1) {
+        uint64_t next = wheel.NextTick();
+        ASSERT_GT(next, wheel.CurrentTick());
+        ASSERT_LE(next, 3600000);
+        wheel.Advance(next, fired);
+        ++woken;
+    }
+    EXPECT_EQ(wheel.CurrentTick(), 3600000);
+    EXPECT_LE(woken, 4 * TimingWheel::kSlots);
+    EXPECT_EQ(wheel.NextTick(), UINT64_MAX);
+}
+
+TEST(TimingWheelTest, CancelManyTimers) {
+    TimingWheel wheel;
+    int count = 0;
+    std::vector<TimingWheel::TimerId> ids;
+
+    const int timers = 100000;
+    for (int i = 0; i < timers; ++i) {
+        ids.push_back(wheel.Schedule(1 + i % 5000, [&count] { ++count; }));
+    }
+    for (int i = 0; i < timers; i += 2) {
+        EXPECT_TRUE(wheel.Cancel(ids[i]));
+    }
+    EXPECT_FALSE(wheel.Cancel(ids[0]));
+    EXPECT_EQ(wheel.Size(), timers / 2);
+
+    std::vector<Function<void>> fired;
+    wheel.Advance(5000, fired);
+    for (auto& callback : fired) {
+        callback();
+    }
+    EXPECT_EQ(count, timers / 2);
+}
+
+TEST(TimerTest, AddAfterWaitsForDelay) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto start = std::chrono::steady_clock::now();
+    auto delayed = scheduler.addAfter(std::chrono::milliseconds(30), [start] {
+        return std::chrono::steady_clock::now() - start;
+    });
+    auto dependent = scheduler.add([](std::chrono::steady_clock::duration elapsed) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    }, scheduler.getFutureResult<std::chrono::steady_clock::duration>(delayed));
+
+    EXPECT_FALSE(delayed->IsExecuted());
+    scheduler.executeAll();
+    EXPECT_GE(scheduler.getResult<long>(dependent), 30);
+}
+
+TEST(TimerTest, PeriodicTaskFeedsDependents) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<int> ticks{0};
+    std::atomic<int> consumed{0};
+    auto periodic = scheduler.addPeriodic(std::chrono::milliseconds(5), [&ticks] {
+        return ++ticks;
+    });
+    scheduler.add([&consumed](int tick) { consumed = tick; },
+                  scheduler.getFutureResult<int>(periodic));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (consumed.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(consumed.load(), 3);
+
+    EXPECT_TRUE(scheduler.cancel(periodic));
+    scheduler.executeAll();
+    int stopped = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(ticks.load(), stopped);
+    EXPECT_FALSE(scheduler.cancel(periodic));
+}
+
+TEST(TimerTest, CancelDelayedTaskSkipsDependents) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    bool ran = false;
+    auto delayed = scheduler.addAfter(std::chrono::seconds(10), [&ran] {
+        ran = true;
+        return 1;
+    });
+    auto dependent = scheduler.add([](int x) { return x + 1; },
+                                   scheduler.getFutureResult<int>(delayed));
+
+    EXPECT_TRUE(scheduler.cancel(delayed));
+    EXPECT_NO_THROW(scheduler.executeAll());
+    EXPECT_THROW(scheduler.getResult<int>(dependent), TaskCancelled);
+    EXPECT_FALSE(ran);
+}
+
+TEST(TimerTest, DestructorCancelsPendingTimers) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+        scheduler.addAfter(std::chrono::seconds(30), [] { return 1; });
+        scheduler.addPeriodic(std::chrono::seconds(30), [] { return 2; });
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(TimerTest, RequiresEagerScheduler) {
+    TTaskScheduler scheduler;
+    EXPECT_THROW(scheduler.addAfter(std::chrono::milliseconds(1), [] { return 1; }),
+                 std::logic_error);
+}
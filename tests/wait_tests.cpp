@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+TEST(WaitTest, ExternalReadersWhileGraphRuns) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    std::atomic<bool> release{false};
+    std::atomic<int> runs{0};
+    auto gate = scheduler.add([&release]() {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 20;
+    });
+    auto middle = scheduler.add([&runs](int x) {
+        ++runs;
+        return x + 1;
+    }, scheduler.getFutureResult<int>(gate));
+
+    std::vector<std::thread> readers;
+    std::vector<int> seen(8, 0);
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back([&scheduler, &middle, &seen, i] {
+            seen[i] = scheduler.getResult<int>(middle);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(seen, std::vector<int>(8, 21));
+    EXPECT_EQ(runs.load(), 1);
+    scheduler.executeAll();
+}
+
+TEST(WaitTest, SerialConcurrentCallersRunTaskOnce) {
+    TTaskScheduler scheduler;
+
+    std::atomic<int> runs{0};
+    auto slow = scheduler.add([&runs]() {
+        ++runs;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return 7;
+    });
+    auto child = scheduler.add([](int x) { return x * 2; }, scheduler.getFutureResult<int>(slow));
+
+    std::vector<std::thread> callers;
+    std::vector<int> seen(4, 0);
+    for (int i = 0; i < 4; ++i) {
+        callers.emplace_back([&scheduler, &child, &seen, i] {
+            seen[i] = scheduler.getResult<int>(child);
+        });
+    }
+    scheduler.executeAll();
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    EXPECT_EQ(runs.load(), 1);
+    EXPECT_EQ(seen, std::vector<int>(4, 14));
+}
+
+TEST(WaitTest, WaiterHelpsWithQueuedWork) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    std::atomic<bool> release{false};
+    scheduler.add([&release]() {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto queued = scheduler.add([]() { return 3; });
+
+    scheduler.wait(queued, true);
+    EXPECT_TRUE(queued->IsExecuted());
+    EXPECT_FALSE(release.load());
+
+    release = true;
+    scheduler.executeAll();
+}
+
+TEST(WaitTest, WorkerWaitingOnQueuedTaskDoesNotDeadlock) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    std::shared_ptr<Task<int>> inner;
+    std::atomic<bool> ready{false};
+    auto outer = scheduler.add([&scheduler, &inner, &ready]() {
+        while (!ready.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        return scheduler.getResult<int>(inner) + 1;
+    });
+    inner = scheduler.add([]() { return 41; });
+    ready.store(true, std::memory_order_release);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(outer), 42);
+}
+
+TEST(WaitTest, WaitRethrowsTaskError) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto failing = scheduler.add([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(scheduler.wait(failing), std::runtime_error);
+    EXPECT_THROW(scheduler.executeAll(), std::runtime_error);
+}
+
+namespace {
+
+std::chrono::nanoseconds ThreadCpuTime() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+}
+
+TEST(WaitTest, WorkerWaitingOnUnfinishedTaskParks) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 2});
+
+    auto slow = scheduler.add([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return 1;
+    });
+    auto waiter = scheduler.add([&scheduler, slow]() {
+        auto start = ThreadCpuTime();
+        scheduler.wait(slow);
+        return ThreadCpuTime() - start;
+    });
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(slow), 1);
+    EXPECT_LT(scheduler.getResult<std::chrono::nanoseconds>(waiter), std::chrono::milliseconds(50));
+}
+
+TEST(WaitTest, ParkedWorkerLeavesLaterWorkRunning) {
+    TTaskScheduler scheduler(SchedulerOptions{.eager = true, .workers = 1});
+
+    auto delayed = scheduler.addAfter(std::chrono::milliseconds(30), []() { return 2; });
+    auto next = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(delayed));
+    auto waiter = scheduler.add([&scheduler, next]() {
+        scheduler.wait(next);
+        return scheduler.getResult<int>(next) * 10;
+    });
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(waiter), 30);
+}
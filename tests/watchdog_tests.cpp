@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "../lib/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(WatchdogTest, ReportsTaskOverFixedThreshold) {
+    std::atomic<int> callbacks{0};
+    TTaskScheduler scheduler(SchedulerOptions{
+        .eager = true,
+        .workers = 2,
+        .watchdog = WatchdogOptions{.threshold = std::chrono::milliseconds(10),
+                                    .on_straggler = [&callbacks](const StragglerReport&) {
+                                        ++callbacks;
+                                    }}});
+
+    auto source = scheduler.add([] { return 1; });
+    auto slow = scheduler.add([](int x) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        return x;
+    }, scheduler.getFutureResult<int>(source));
+    auto left = scheduler.add([](int x) { return x + 1; }, scheduler.getFutureResult<int>(slow));
+    auto right = scheduler.add([](int x) { return x + 2; }, scheduler.getFutureResult<int>(slow));
+    scheduler.add([](int l, int r) { return l + r; },
+                  scheduler.getFutureResult<int>(left), scheduler.getFutureResult<int>(right));
+    scheduler.executeAll();
+
+    std::vector<StragglerReport> reports = scheduler.stragglers();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(callbacks.load(), 1);
+
+    const StragglerReport& report = reports.front();
+    EXPECT_EQ(report.task_id, scheduler.getRef(slow).Index());
+    EXPECT_EQ(report.depth, 1);
+    EXPECT_GE(report.elapsed, std::chrono::milliseconds(10));
+    EXPECT_EQ(report.limit, std::chrono::milliseconds(10));
+
+    std::vector<uint32_t> waiting = report.waiting;
+    std::sort(waiting.begin(), waiting.end());
+    EXPECT_EQ(waiting, std::vector<uint32_t>({scheduler.getRef(left).Index(),
+                                              scheduler.getRef(right).Index()}));
+    EXPECT_EQ(report.blocked, 3);
+}
+
+TEST(WatchdogTest, LearnsPerCallableRunTime) {
+    TTaskScheduler scheduler(SchedulerOptions{
+        .watchdog = WatchdogOptions{.factor = 5, .min_samples = 8}});
+
+    auto make = [&scheduler](std::chrono::milliseconds duration) {
+        return scheduler.add([duration] {
+            std::this_thread::sleep_for(duration);
+            return 0;
+        });
+    };
+    for (int i = 0; i < 10; ++i) {
+        make(std::chrono::milliseconds(1));
+    }
+    auto slow = make(std::chrono::milliseconds(80));
+    scheduler.add([] { std::this_thread::sleep_for(std::chrono::milliseconds(30)); });
+    scheduler.executeAll();
+
+    std::vector<StragglerReport> reports = scheduler.stragglers();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports.front().task_id, scheduler.getRef(slow).Index());
+    EXPECT_LT(reports.front().limit, std::chrono::milliseconds(30));
+}
+
+TEST(WatchdogTest, LearnsFromEveryWorker) {
+    TTaskScheduler scheduler(SchedulerOptions{
+        .eager = true,
+        .workers = 4,
+        .watchdog = WatchdogOptions{.factor = 5, .min_samples = 8}});
+
+    auto make = [&scheduler](std::chrono::milliseconds duration) {
+        return scheduler.add([duration] {
+            std::this_thread::sleep_for(duration);
+            return 0;
+        });
+    };
+    for (int i = 0; i < 64; ++i) {
+        make(std::chrono::milliseconds(1));
+    }
+    scheduler.executeAll();
+    auto slow = make(std::chrono::milliseconds(80));
+    scheduler.executeAll();
+
+    std::vector<StragglerReport> reports = scheduler.stragglers();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports.front().task_id, scheduler.getRef(slow).Index());
+    EXPECT_LT(reports.front().limit, std::chrono::milliseconds(30));
+}
+
+TEST(WatchdogTest, DisabledByDefault) {
+    TTaskScheduler scheduler;
+    scheduler.add([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+    scheduler.executeAll();
+    EXPECT_TRUE(scheduler.stragglers().empty());
+}